@@ -0,0 +1,75 @@
+// 各个编码微基准共用的 LEB128 参考实现、吞吐计算与命令行解析
+#ifndef LOGMD_BENCH_HPP
+#define LOGMD_BENCH_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 与 SubTokenCompressor::write_unsigned_leb128 的格式相同
+template <class T>
+inline void leb128_encode(const std::vector<T> &values, std::string &out) {
+  for (T v : values) {
+    do {
+      uint8_t byte = v & 0x7F;
+      v >>= 7;
+      out.push_back(char(v ? byte | 0x80 : byte));
+    } while (v);
+  }
+}
+
+// 与 SubTokenCompressor::read_unsigned_leb128 的格式相同，
+// 依次读出 out.size() 个值
+template <class T>
+inline void leb128_decode(const std::string &in, std::vector<T> &out) {
+  const char *cur = in.data();
+  for (auto &v : out) {
+    uint64_t result = 0;
+    uint32_t shift = 0;
+    uint8_t byte;
+    do {
+      byte = uint8_t(*cur++);
+      result |= uint64_t(byte & 0x7F) << shift;
+      shift += 7;
+    } while (byte & 0x80);
+    v = T(result);
+  }
+}
+
+// 每秒处理的原始值字节数（GB/s），value_size 为单个值的字节数
+inline double gbps(size_t values, size_t value_size, size_t rounds,
+                   double seconds) {
+  return double(values * value_size) * rounds / seconds / 1e9;
+}
+
+inline double seconds_between(std::chrono::steady_clock::time_point from,
+                              std::chrono::steady_clock::time_point to) {
+  return std::chrono::duration<double>(to - from).count();
+}
+
+// 用法均为 <bench> [values] [rounds] [param...]，param 缺省时取 defaults
+struct Options {
+  size_t values = 1 << 20;
+  size_t rounds = 20;
+  std::vector<uint32_t> params;
+};
+
+inline Options parse_options(int argc, char *argv[],
+                             std::vector<uint32_t> defaults) {
+  Options options;
+  if (argc > 1)
+    options.values = strtoul(argv[1], nullptr, 10);
+  if (argc > 2)
+    options.rounds = strtoul(argv[2], nullptr, 10);
+  for (int i = 3; i < argc; ++i)
+    options.params.push_back(uint32_t(strtoul(argv[i], nullptr, 10)));
+  if (options.params.empty())
+    options.params = std::move(defaults);
+  return options;
+}
+
+#endif // LOGMD_BENCH_HPP
@@ -0,0 +1,66 @@
+// 比较 LEB128 与 FOR 位打包在数字列上的编码、解码吞吐与体积，
+// 并核对位打包能否还原原始值。
+// 输入模拟定长数字列：base 附近、位宽为 width 的随机值。
+// 用法：bitpacking_bench [values] [rounds] [width...]
+#include "bench.hpp"
+#include "utils/BitPacking.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace chr = std::chrono;
+using namespace std;
+
+int main(int argc, char *argv[]) {
+  auto options = parse_options(argc, argv, {4, 10, 17, 27, 40});
+  size_t n = options.values, rounds = options.rounds;
+  mt19937_64 rng(42);
+
+  size_t mismatches = 0;
+  cout << n << " values x " << rounds << " rounds, GB/s of uint64 values\n";
+  for (uint32_t width : options.params) {
+    uint64_t mask = width >= 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+    vector<uint64_t> values(n), decoded(n);
+    for (auto &v : values)
+      v = 1000000 + (rng() & mask);
+
+    string leb, packed;
+    double leb_enc = 0, leb_dec = 0, bp_enc = 0, bp_dec = 0;
+    ForFrame frame;
+    for (size_t r = 0; r < rounds; ++r) {
+      leb.clear();
+      packed.clear();
+      auto t0 = chr::steady_clock::now();
+      leb128_encode(values, leb);
+      auto t1 = chr::steady_clock::now();
+      leb128_decode(leb, decoded);
+      auto t2 = chr::steady_clock::now();
+      frame = for_frame(values.data(), n);
+      for_pack(values.data(), n, frame, packed);
+      auto t3 = chr::steady_clock::now();
+      for_unpack(packed.data(), n, frame, decoded.data());
+      auto t4 = chr::steady_clock::now();
+      leb_enc += seconds_between(t0, t1);
+      leb_dec += seconds_between(t1, t2);
+      bp_enc += seconds_between(t2, t3);
+      bp_dec += seconds_between(t3, t4);
+      if (decoded != values)
+        ++mismatches;
+    }
+
+    cout << fixed << setprecision(2) << "width " << width << ":\n"
+         << "  LEB128: " << leb.size() << " bytes, encode "
+         << gbps(n, sizeof(uint64_t), rounds, leb_enc) << ", decode "
+         << gbps(n, sizeof(uint64_t), rounds, leb_dec) << "\n"
+         << "  FOR bit-packing: " << packed.size() << " bytes, encode "
+         << gbps(n, sizeof(uint64_t), rounds, bp_enc) << ", decode "
+         << gbps(n, sizeof(uint64_t), rounds, bp_dec) << endl;
+  }
+  cout << mismatches << " mismatches" << endl;
+  return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+// 比较 FPGrowth 与 ArenaFPGrowth 在 process_patterns_exp 式输入上的耗时，
+// 并核对两者挖出的模式数与最长模式一致。
+// 输入模拟 new_missing_matrix_hashset：若干互不相同的行，每行 cols 列，
+// 其中 common 列为所有行相同的常量，其余列取自较小的值域。
+// 用法：fpgrowth_bench [rows] [cols] [common] [rounds]
+#include "utils/ArenaFPGrowth.hpp"
+#include "utils/fpgrow.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace chr = std::chrono;
+using namespace std;
+
+static vector<vector<string>> make_rows(size_t rows, size_t cols,
+                                        size_t common, mt19937 &rng) {
+  set<vector<string>> unique_rows;
+  size_t vocab = max<size_t>(4, rows / 4);
+  while (unique_rows.size() < rows) {
+    vector<string> row;
+    for (size_t k = 0; k < cols; ++k) {
+      if (k < common)
+        row.push_back("c" + to_string(k));
+      else
+        row.push_back("v" + to_string(k) + "_" + to_string(rng() % vocab));
+    }
+    unique_rows.insert(move(row));
+  }
+  return {unique_rows.begin(), unique_rows.end()};
+}
+
+// 与 mine_sole_pattern 相同：取第一个最长的模式
+template <typename Patterns>
+static size_t longest(const Patterns &patterns) {
+  size_t best = 0;
+  for (size_t i = 1; i < patterns.size(); ++i) {
+    if (patterns[i].first.size() > patterns[best].first.size())
+      best = i;
+  }
+  return best;
+}
+
+static vector<string> run_fpgrowth(const vector<vector<string>> &rows,
+                                   size_t &pattern_count) {
+  vector<vector<shared_ptr<string>>> matrix_vec;
+  matrix_vec.reserve(rows.size());
+  for (auto &row : rows) {
+    vector<shared_ptr<string>> row_vec;
+    row_vec.reserve(row.size());
+    for (auto &item : row)
+      row_vec.push_back(make_shared<string>(item));
+    matrix_vec.emplace_back(move(row_vec));
+  }
+  FPGrowth fp_growth(move(matrix_vec), rows.size());
+  auto patterns = fp_growth.run();
+  pattern_count = patterns.size();
+  vector<string> best;
+  if (!patterns.empty()) {
+    for (auto &item : patterns[longest(patterns)].first)
+      best.push_back(*item);
+  }
+  return best;
+}
+
+static vector<string> run_arena(const vector<vector<string>> &rows,
+                                size_t &pattern_count) {
+  FPItemIds items;
+  ArenaFPGrowth fp_growth(rows.size());
+  vector<uint32_t> row_ids;
+  for (auto &row : rows) {
+    row_ids.clear();
+    for (auto &item : row)
+      row_ids.push_back(items.add(item));
+    fp_growth.add_transaction(row_ids.data(), row_ids.size());
+  }
+  auto patterns = fp_growth.run(items.order());
+  pattern_count = patterns.size();
+  vector<string> best;
+  if (!patterns.empty()) {
+    for (auto id : patterns[longest(patterns)].first)
+      best.emplace_back(items[id]);
+  }
+  return best;
+}
+
+int main(int argc, char *argv[]) {
+  size_t rows = argc > 1 ? strtoul(argv[1], nullptr, 10) : 2000;
+  size_t cols = argc > 2 ? strtoul(argv[2], nullptr, 10) : 8;
+  size_t common = argc > 3 ? strtoul(argv[3], nullptr, 10) : 5;
+  size_t rounds = argc > 4 ? strtoul(argv[4], nullptr, 10) : 20;
+  mt19937 rng(42);
+
+  size_t mismatches = 0;
+  double old_s = 0, arena_s = 0;
+  for (size_t r = 0; r < rounds; ++r) {
+    auto input = make_rows(rows, cols, min(common, cols), rng);
+    size_t old_count, arena_count;
+
+    auto t0 = chr::steady_clock::now();
+    auto expected = run_fpgrowth(input, old_count);
+    auto t1 = chr::steady_clock::now();
+    auto actual = run_arena(input, arena_count);
+    auto t2 = chr::steady_clock::now();
+    old_s += chr::duration<double>(t1 - t0).count();
+    arena_s += chr::duration<double>(t2 - t1).count();
+
+    if (expected != actual || old_count != arena_count)
+      ++mismatches;
+  }
+
+  cout << rounds << " rounds of " << rows << " rows x " << cols << " cols ("
+       << common << " common), " << mismatches << " mismatches\n"
+       << fixed << setprecision(3) << "  FPGrowth: " << old_s * 1000 / rounds
+       << " ms/round\n"
+       << "  ArenaFPGrowth: " << arena_s * 1000 / rounds << " ms/round ("
+       << setprecision(2) << old_s / arena_s << "x)" << endl;
+  return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+// 比较 LEB128 与 Stream VByte 在 id 流上的编码、解码吞吐与体积，
+// 并核对 Stream VByte 能否还原原始值。
+// 输入模拟 tokenid / templateid：小 id 居多，每个值的位数在
+// [0, max_bits] 中均匀选取。
+// 用法：streamvbyte_bench [values] [rounds] [max_bits...]
+#include "bench.hpp"
+#include "utils/StreamVByte.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace chr = std::chrono;
+using namespace std;
+
+int main(int argc, char *argv[]) {
+  auto options = parse_options(argc, argv, {7, 12, 16, 24, 32});
+  size_t n = options.values, rounds = options.rounds;
+  mt19937 rng(42);
+
+  size_t mismatches = 0;
+  cout << n << " values x " << rounds << " rounds, GB/s of uint32 values\n";
+  for (uint32_t bits : options.params) {
+    vector<uint32_t> values(n), decoded(n);
+    for (auto &v : values) {
+      uint32_t b = rng() % (bits + 1);
+      v = b == 0 ? 0 : uint32_t(rng() >> (32 - b));
+    }
+
+    string leb;
+    vector<uint8_t> svb(svb_max_size(n));
+    size_t svb_size = 0;
+    double leb_enc = 0, leb_dec = 0, svb_enc = 0, svb_dec = 0;
+    for (size_t r = 0; r < rounds; ++r) {
+      leb.clear();
+      auto t0 = chr::steady_clock::now();
+      leb128_encode(values, leb);
+      auto t1 = chr::steady_clock::now();
+      leb128_decode(leb, decoded);
+      auto t2 = chr::steady_clock::now();
+      svb_size = svb_encode(values.data(), n, svb.data());
+      auto t3 = chr::steady_clock::now();
+      bool ok = svb_decode(svb.data(), svb_size, n, decoded.data());
+      auto t4 = chr::steady_clock::now();
+      leb_enc += seconds_between(t0, t1);
+      leb_dec += seconds_between(t1, t2);
+      svb_enc += seconds_between(t2, t3);
+      svb_dec += seconds_between(t3, t4);
+      if (!ok || decoded != values)
+        ++mismatches;
+    }
+
+    cout << fixed << setprecision(2) << "max bits " << bits << ":\n"
+         << "  LEB128: " << leb.size() << " bytes, encode "
+         << gbps(n, sizeof(uint32_t), rounds, leb_enc) << ", decode "
+         << gbps(n, sizeof(uint32_t), rounds, leb_dec) << "\n"
+         << "  Stream VByte: " << svb_size << " bytes, encode "
+         << gbps(n, sizeof(uint32_t), rounds, svb_enc) << ", decode "
+         << gbps(n, sizeof(uint32_t), rounds, svb_dec) << endl;
+  }
+  cout << mismatches << " mismatches" << endl;
+  return mismatches == 0 ? 0 : 1;
+}
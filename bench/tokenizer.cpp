@@ -0,0 +1,116 @@
+// 比较 MAIN_TOKEN_RE 正则切分与 split_tokens 的吞吐量，并核对两者结果一致。
+// 用法：tokenizer_bench <log file>...（例如 LogHub 的 *_2k.log 或完整数据集）
+#include "utils/LineSpans.hpp"
+#include "utils/MappedFile.hpp"
+#include "utils/TokenSplitter.hpp"
+#include "utils/pcre2regex.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace chr = std::chrono;
+using namespace std;
+
+static void encode_utf8(uint32_t cp, string &out) {
+  if (cp < 0x80) {
+    out += char(cp);
+  } else if (cp < 0x800) {
+    out += char(0xC0 | (cp >> 6));
+    out += char(0x80 | (cp & 0x3F));
+  } else if (cp < 0x10000) {
+    out += char(0xE0 | (cp >> 12));
+    out += char(0x80 | ((cp >> 6) & 0x3F));
+    out += char(0x80 | (cp & 0x3F));
+  } else {
+    out += char(0xF0 | (cp >> 18));
+    out += char(0x80 | ((cp >> 12) & 0x3F));
+    out += char(0x80 | ((cp >> 6) & 0x3F));
+    out += char(0x80 | (cp & 0x3F));
+  }
+}
+
+static void regex_tokens(Pcre2Regex &re, string_view line,
+                         vector<string> &tokens) {
+  for (auto it = re.get_iter(line); !it.end(); it.next()) {
+    auto [start, end] = it.cap();
+    tokens.emplace_back(line.substr(start, end - start));
+  }
+}
+
+static void simd_tokens(string_view line, vector<string> &tokens) {
+  split_tokens(line, [&](string_view token) { tokens.emplace_back(token); });
+}
+
+// 每个 Unicode 码位前后各夹一个字母，确认 \s 的判定与正则完全相同
+static size_t check_all_code_points(Pcre2Regex &re) {
+  size_t mismatches = 0;
+  vector<string> expected, actual;
+  for (uint32_t cp = 1; cp <= 0x10FFFF; ++cp) {
+    if (cp >= 0xD800 && cp <= 0xDFFF)
+      continue;
+    string line = "a";
+    encode_utf8(cp, line);
+    line += 'b';
+    expected.clear();
+    actual.clear();
+    regex_tokens(re, line, expected);
+    simd_tokens(line, actual);
+    if (expected != actual && mismatches++ < 10)
+      cerr << "Mismatch at U+" << hex << uppercase << cp << dec << endl;
+  }
+  return mismatches;
+}
+
+int main(int argc, char *argv[]) {
+  Pcre2Regex re(R"(([^\s|]+)|(\s)|(\|))");
+  size_t mismatches = check_all_code_points(re);
+  cout << "Code point check: " << mismatches << " mismatches" << endl;
+
+  for (int i = 1; i < argc; ++i) {
+    MappedFile file(argv[i]);
+    LineSpans lines(file.data(), file.size());
+
+    vector<string> expected, actual;
+    size_t line_mismatches = 0, tokens = 0;
+    for (size_t j = 0; j < lines.size(); ++j) {
+      expected.clear();
+      actual.clear();
+      regex_tokens(re, lines[j], expected);
+      simd_tokens(lines[j], actual);
+      tokens += expected.size();
+      if (expected != actual)
+        ++line_mismatches;
+    }
+
+    // 与解析器相同，每个 token 都复制为 std::string
+    auto time = [&](auto fn) {
+      vector<string> out;
+      auto t0 = chr::steady_clock::now();
+      for (size_t j = 0; j < lines.size(); ++j) {
+        out.clear();
+        fn(lines[j], out);
+      }
+      return chr::duration<double>(chr::steady_clock::now() - t0).count();
+    };
+    double regex_s = time([&](string_view line, vector<string> &out) {
+      regex_tokens(re, line, out);
+    });
+    double simd_s = time(simd_tokens);
+
+    double mb = file.size() / 1e6;
+    cout << argv[i] << ": " << lines.size() << " lines, " << tokens
+         << " tokens, " << line_mismatches << " mismatched lines\n"
+         << fixed << setprecision(1) << "  pcre2: " << mb / regex_s
+         << " MB/s\n"
+         << "  split_tokens: " << mb / simd_s << " MB/s ("
+         << setprecision(2) << regex_s / simd_s << "x)" << defaultfloat
+         << endl;
+    mismatches += line_mismatches;
+  }
+  return mismatches == 0 ? 0 : 1;
+}
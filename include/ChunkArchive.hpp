@@ -0,0 +1,45 @@
+#ifndef LOGMD_CHUNKARCHIVE_HPP
+#define LOGMD_CHUNKARCHIVE_HPP
+
+#include "Codec.hpp"
+#include "utils/IndexMap.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 一个块的全部输出流（l1_0.bin、templateid.bin、token.txt ...），
+// 只保存在内存中，最后一次性打包压缩写出，不落地临时文件
+class ChunkArchive {
+private:
+  std::string _path; // 不含扩展名的输出路径，如 output/0
+  IndexMap<std::string, std::string> files;
+
+public:
+  ChunkArchive() = default;
+  explicit ChunkArchive(std::string path) : _path(std::move(path)) {}
+
+  // 取得（必要时新建）名为 name 的流，相当于以截断方式打开文件
+  std::string &file(const std::string &name) {
+    auto &data = files[name];
+    data.clear();
+    return data;
+  }
+
+  std::vector<std::pair<std::string, std::string>> &entries() {
+    return files.to_vector();
+  }
+  const std::string &path() const { return _path; }
+
+  // 按 ustar 格式序列化，与 tar -cf 的结果可以互换；
+  // 不少于 100 字节的流名与 GNU tar 一样写成 ././@LongLink 条目
+  std::string to_tar();
+  // to_tar 的逆过程，也接受 tar -C dir -cf 生成的 ./ 前缀与 GNU 长文件名，
+  // 忽略目录等非普通文件
+  static ChunkArchive from_tar(const std::string &tar);
+  // 压缩后写出 <path> + codec_extension(codec)
+  void write(const Codec &codec);
+};
+
+#endif // LOGMD_CHUNKARCHIVE_HPP
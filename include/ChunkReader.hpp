@@ -0,0 +1,54 @@
+#ifndef LOGMD_CHUNKREADER_HPP
+#define LOGMD_CHUNKREADER_HPP
+
+#include "utils/LineSpans.hpp"
+#include "utils/MappedFile.hpp"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// 一个待压缩的日志块。普通文件的行内容直接指向映射区域，
+// 管道/标准输入读到的内容则由块自身的 storage 持有
+struct LogChunk {
+  size_t chunk_idx = 0;
+  size_t first_line = 0; // 块内第一行的全局行号
+  size_t offset = 0;     // 块在文件中的字节范围（仅映射模式）
+  size_t length = 0;
+  std::vector<char> storage;
+  LineSpans lines;
+};
+
+// 边读边切块：每次只向后扫描 chunk_size 行，
+// 不需要先找出整个文件的行边界。
+// 输入为 "-" 或不可映射的文件（FIFO、字符设备等）时改为 read 流式读取
+class ChunkReader {
+private:
+  MappedFile file;
+  int fd = -1;
+  bool is_stream = false;
+  bool eof = false;
+  std::vector<char> carry; // 流模式下读多了的、属于下一个块的数据
+  std::vector<char> block; // 流模式下 read 的暂存区，只追加实际读到的字节
+  size_t chunk_size;
+  size_t pos = 0;
+  size_t next_chunk_idx = 0;
+  size_t next_line = 0;
+
+  bool next_mapped(LogChunk &chunk);
+  bool next_stream(LogChunk &chunk);
+
+public:
+  ChunkReader(const std::string &filename, size_t chunk_size);
+  ~ChunkReader();
+
+  // 禁用拷贝
+  ChunkReader(const ChunkReader &) = delete;
+  ChunkReader &operator=(const ChunkReader &) = delete;
+
+  // 读取下一个块，输入结束时返回 false
+  bool next(LogChunk &chunk);
+  // 块处理完毕后归还其占用的页
+  void release(const LogChunk &chunk) const;
+};
+
+#endif // LOGMD_CHUNKREADER_HPP
@@ -0,0 +1,43 @@
+#ifndef LOGMD_CODEC_HPP
+#define LOGMD_CODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 归档最后一步使用的通用压缩器
+enum class CodecType : uint8_t { STORE = 0, XZ = 1, ZSTD = 2 };
+
+struct Codec {
+  CodecType type = CodecType::XZ;
+  int level = 6;       // xz: 0 ~ 9，zstd: 1 ~ 22
+  bool extreme = true; // 仅 xz，对应 -e / --extreme
+  int window_log = 0;  // 仅 zstd，非 0 时开启 --long=window_log
+};
+
+// 解析命令行中的压缩器描述，例如
+//   store
+//   xz, xz:9, xz:6e
+//   zstd, zstd:19, zstd:19:long, zstd:22:long=31
+Codec parse_codec(const std::string &spec);
+// 压缩器的可读名称，格式与 parse_codec 的输入相同
+std::string codec_name(const Codec &codec);
+// 归档文件扩展名：.tar / .tar.xz / .tar.zst
+const char *codec_extension(const Codec &codec);
+
+// 在内存中一次性压缩 input，结果覆盖 output。
+// xz 与 zstd 都是自描述的格式，解压时可通过文件头识别
+void codec_compress(const Codec &codec, const std::string &input,
+                    std::string &output);
+
+// codec_compress 的逆过程，按文件头识别 xz / zstd，其余视为未压缩
+void codec_decompress(const char *data, size_t size, std::string &output);
+
+// 单文件容器中的一个流：不带 xz 文件头（raw LZMA2）/ zstd 校验和，
+// 以减少小流的固定开销，原始长度与 CRC32 由容器目录记录并在读取时核对
+void codec_compress_block(const Codec &codec, const char *data, size_t size,
+                          std::string &output);
+void codec_decompress_block(const Codec &codec, const char *data, size_t size,
+                            size_t raw_size, std::string &output);
+
+#endif // LOGMD_CODEC_HPP
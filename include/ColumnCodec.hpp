@@ -0,0 +1,54 @@
+#ifndef LOGMD_COLUMNCODEC_HPP
+#define LOGMD_COLUMNCODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 数字列的编码方式，取值即写在列数据之前的标记
+enum class ColumnCodec : uint8_t {
+  RAW = 0,   // 原始值 LEB128
+  DELTA = 1, // 与前一个值的差，有符号 LEB128（与 zigzag 后的无符号等长）
+  FOR = 2,   // 帧参考 + 位打包，见 utils/BitPacking.hpp
+  DELTA_OF_DELTA = 3, // 相邻差值的差，有符号 LEB128
+  // 4 保留不用：(值, 重复次数) 对只在 ColumnCost 中估计，读取时视为未知
+  DICT = 5, // 按出现次数降序的字典，之后为每个值在字典中的序号
+};
+inline constexpr ColumnCodec COLUMN_CODECS[] = {
+    ColumnCodec::RAW, ColumnCodec::DELTA, ColumnCodec::FOR,
+    ColumnCodec::DELTA_OF_DELTA, ColumnCodec::DICT};
+// 标记的上界，ColumnCost::bytes 按标记取下标
+inline constexpr size_t COLUMN_CODEC_COUNT = 6;
+
+const char *column_codec_name(ColumnCodec codec);
+
+// 一列数字在各编码方式下写出的字节数（含标记），以及胜出的编码方式。
+// 无法使用的编码方式与保留的标记记为 SIZE_MAX
+struct ColumnCost {
+  size_t values = 0;
+  size_t bytes[COLUMN_CODEC_COUNT] = {};
+  // 按 (值, 重复次数) 对写出的字节数，只用于 --codec-stats：重复的值在
+  // delta 后是连续的 0，xz 与 zstd 对其的压缩效果更好，实测选用反而变大
+  size_t rle_bytes = 0;
+  ColumnCodec best = ColumnCodec::RAW;
+};
+
+// standalone 为 true 表示独立的数字流 l<len>_0.bin：RAW 为有符号 LEB128 且
+// 读到流尾，RAW 与 DELTA 之外的编码在标记之后写出值的个数。
+// 矩阵的列则由矩阵头给出值的个数
+
+// 对整列做一遍估计，挑出写出字节数最少的编码方式。
+// legacy 为 true 时只在 Python 脚本能读取的 RAW 与 DELTA 中挑选
+ColumnCost estimate_column(const std::vector<uint64_t> &values,
+                           bool standalone, bool legacy = false);
+// 写出标记与按 codec 编码的数据
+void write_column(std::string &writer, const std::vector<uint64_t> &values,
+                  ColumnCodec codec, bool standalone);
+// 读取标记与数据追加到 out，返回之后的位置。矩阵的列有 n 个值，
+// 独立的数字流忽略 n
+const char *read_column(const char *cur, const char *end, size_t n,
+                        bool standalone, std::vector<uint64_t> &out,
+                        const std::string &stream_name);
+
+#endif // LOGMD_COLUMNCODEC_HPP
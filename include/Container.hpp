@@ -0,0 +1,102 @@
+#ifndef LOGMD_CONTAINER_HPP
+#define LOGMD_CONTAINER_HPP
+
+#include "ChunkArchive.hpp"
+#include "Codec.hpp"
+#include "utils/MappedFile.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 单文件容器（.lfa）布局：
+//   "LGFA" + 版本号                       文件头，5 字节
+//   块 0 的数据 | 块 1 的数据 | ...       按写出顺序排列，每个流单独压缩
+//   共享区的数据（可选）                  跨块共享的流，如共享模板字典
+//   目录                                  压缩器参数、每个块的字节范围与
+//                                         行号范围、块内每个流的偏移，
+//                                         版本 2 在末尾追加共享区的流，
+//                                         版本 3 另记每个流的 CRC32 并
+//                                         总是写出共享区（可能没有流）
+//   目录偏移 u64 | 目录长度 u64 | "LGFA"  文件尾，20 字节
+// 目录中的整数均为无符号 LEB128，文件尾为小端序。
+// 读取时先读文件尾再读目录，之后可以直接定位到任意一个块或一个流
+
+struct StreamEntry {
+  std::string name;  // 与 tar 归档中的文件名相同，如 templateid.bin
+  uint64_t offset;   // 相对所在块起点的偏移
+  uint64_t size;     // 压缩后长度
+  uint64_t raw_size; // 原始长度
+  uint32_t crc32;    // 原始数据的 CRC32，版本 3 之前的容器中没有记录
+};
+
+struct ChunkEntry {
+  uint64_t chunk_idx;
+  uint64_t first_line; // 块内第一行的全局行号
+  uint64_t line_count;
+  uint64_t offset; // 块在容器中的绝对偏移
+  uint64_t size;
+  std::vector<StreamEntry> streams;
+};
+
+// 多个归档线程共用一个写入器：压缩在调用线程中完成，
+// 只有追加写文件与登记目录需要加锁
+class ContainerWriter {
+private:
+  std::string path;
+  std::ofstream writer;
+  Codec codec;
+  uint64_t pos = 0;
+  std::vector<ChunkEntry> chunks;
+  ChunkEntry shared{}; // 共享区，可能没有流
+  std::mutex mtx;
+
+  ChunkEntry write_entry(ChunkArchive &archive);
+
+public:
+  ContainerWriter(std::string path, const Codec &codec);
+
+  // 禁用拷贝
+  ContainerWriter(const ContainerWriter &) = delete;
+  ContainerWriter &operator=(const ContainerWriter &) = delete;
+
+  void append(uint64_t chunk_idx, uint64_t first_line, uint64_t line_count,
+              ChunkArchive &archive);
+  // 写入共享区，只能调用一次
+  void set_shared(ChunkArchive &archive);
+  // 写出目录与文件尾，之后不能再 append
+  void finish();
+};
+
+class ContainerReader {
+private:
+  MappedFile file;
+  Codec _codec;
+  std::vector<ChunkEntry> _chunks; // 按 chunk_idx 升序
+  ChunkEntry _shared{};
+  bool has_crc = false; // 版本 3 起记录了每个流的 CRC32
+
+public:
+  explicit ContainerReader(const std::string &path);
+
+  const Codec &codec() const { return _codec; }
+  const std::vector<ChunkEntry> &chunks() const { return _chunks; }
+  // 共享区，版本 1 的容器中没有流
+  const ChunkEntry &shared() const { return _shared; }
+
+  // 按名字查找块内的流，不存在时返回 nullptr
+  static const StreamEntry *find_stream(const ChunkEntry &chunk,
+                                        const std::string &name);
+  // 只解压一个流，并核对 CRC32
+  std::string read_stream(const ChunkEntry &chunk,
+                          const StreamEntry &stream) const;
+  // 解压整个块，内容与 tar 归档中的文件一一对应
+  ChunkArchive read_chunk(const ChunkEntry &chunk) const;
+};
+
+// 容器文件名，位于输出目录下
+inline constexpr const char *CONTAINER_FILE_NAME = "logfold.lfa";
+
+#endif // LOGMD_CONTAINER_HPP
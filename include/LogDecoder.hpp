@@ -0,0 +1,116 @@
+#ifndef LOGMD_LOGDECODER_HPP
+#define LOGMD_LOGDECODER_HPP
+
+#include "arg.hpp"
+#include "utils/SubTokenType.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+void decompress_logs(const Args &args);
+// --get：只还原指定行
+void get_logs(const Args &args);
+
+// 随机访问：只解码包含全局第 [first_line, first_line + count) 行
+// （从 0 开始）的块。path 与 -d 的输入相同，容器可按目录直接定位块，
+// 块内只解压模板 id、tokenid 与这些行用到的列
+std::string read_log_lines(const std::string &path, uint64_t first_line,
+                           uint64_t count);
+// 读取 --shared-templates 输出中的共享模板字典，path 与 -d 的输入相同
+std::string read_shared_templates(const std::string &path);
+
+// 一个块的流来源。tar 归档一次性解出全部流，
+// 容器则只解压真正用到的流
+struct ChunkStreams {
+  std::vector<std::string> names;
+  // 流不存在时返回 false
+  std::function<bool(const std::string &name, std::string &data)> read;
+  // 共享模板字典，排在块内 template.txt 之前；由调用方持有
+  std::string_view shared_templates;
+  // 出错时用于指明是哪个块，如 chunk 3 或 tar 归档的路径
+  std::string source;
+};
+
+// 把一个块的各个流还原为原始日志行，
+// 与 decompression/ 下的 Python 脚本链结果一致。
+// 流缺失或值不够用时不写出占位文本，而是指明块与流后报错退出
+class ChunkDecoder {
+private:
+  // 模板预先拆成操作序列，还原每一行时只需顺序执行
+  enum class OpType : uint8_t {
+    LITERAL,   // 模板中的原文
+    TOKEN_ID,  // <*>，取 tokenid 流的下一个 id
+    NUMBER,    // <a> ~ <o>，取对应长度数字流的下一个值
+    DICT,      // |a|，dict id 对应的子 token 或模式
+    TIMESTAMP, // <t格式编号>，取对应格式时间戳流的下一个值
+  };
+  struct Op {
+    OpType type;
+    // NUMBER 为数字长度，DICT 为 dict id，TIMESTAMP 为格式编号
+    uint64_t arg;
+    std::string_view text;
+  };
+
+  // 一个数字流 l<len>_0.bin，或时间戳流 t<format>.bin
+  struct NumberStream {
+    bool loaded = false;
+    bool exists = false;
+    std::vector<uint64_t> values;
+    size_t cursor = 0;
+  };
+
+  // 一个变量矩阵 _<dict_id>_....bin，按实例（行）依次取用
+  struct MatrixStream {
+    std::string name;
+    bool is_delta = false;
+    std::vector<int32_t> lengths;
+    std::vector<SubTokenType> types; // 与 lengths 等长
+    bool loaded = false;
+    size_t positions = 0, instances = 0;
+    // positions * instances，按位置存放；超过 16 位的十六进制列占两个位置
+    std::vector<uint64_t> values;
+    std::vector<std::string_view> pattern_parts; // 模式按 <> 切开
+    size_t cursor = 0;
+  };
+
+  ChunkStreams streams;
+  std::string template_data, token_data;
+  std::vector<std::vector<Op>> templates;
+  std::vector<std::string_view> tokens;
+  std::vector<uint32_t> template_ids;
+  std::vector<uint32_t> token_ids; // 构造时整体解码，按 token_id_pos 取用
+  size_t token_id_pos = 0;
+  std::string token_id_stream; // token_ids 所在的流名，用于报错
+  NumberStream numbers[16];
+  std::vector<NumberStream> timestamps; // 下标为格式编号
+  std::vector<std::pair<uint64_t, MatrixStream>> matrices; // 按 dict id 排序
+
+  void corrupt(const std::string &problem, const std::string &detail) const;
+  std::string read_stream(const std::string &name, bool required);
+  void compile_template(std::string_view templ, std::vector<Op> &ops);
+  void append_number(std::string &out, size_t length);
+  void append_timestamp(std::string &out, size_t format);
+  bool is_composite(uint64_t dict_id) const;
+  MatrixStream *find_matrix(uint64_t dict_id);
+  void append_dict(std::string &out, uint64_t dict_id);
+  void skip_dict(uint64_t dict_id);
+  void skip_line(const std::vector<Op> &ops);
+  void append_instance(std::string &out, MatrixStream &matrix);
+  void load_numbers(size_t length);
+  void load_timestamps(size_t format);
+  void load_matrix(MatrixStream &matrix);
+
+public:
+  explicit ChunkDecoder(ChunkStreams streams);
+
+  size_t line_count() const { return template_ids.size(); }
+  // 还原块内第 [first, first + count) 行，每行以换行符结尾，追加到 out。
+  // 之前的行只推进游标，只有这些行用到的列才会被读取与解码。
+  // 每个 ChunkDecoder 只能调用一次
+  void decode(std::string &out, size_t first = 0, size_t count = SIZE_MAX);
+};
+
+#endif // LOGMD_LOGDECODER_HPP
@@ -8,63 +8,112 @@
 #include "utils/Array2.hpp"
 #include "utils/IndexMap.hpp"
 #include "utils/pcre2regex.hpp"
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <map>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <utils/IndexManager.hpp>
+#include <utils/LineSpans.hpp>
+#include <utils/RuntimeSpace.hpp>
 #include <vector>
 
+// 挖掘一个 sole pattern 得到的全部输出，按产生的顺序记录。
+// 挖掘可以并行进行，之后由 merge_mined_pattern 按 sole pattern 的顺序写回
+// exp_rules_dict 与 token_manager，保证 id 与串行执行时相同
+struct MinedPattern {
+  struct MatrixRecord {
+    std::string pattern; // 要注册的 pattern，合并时得到 dict id
+    int8_t init_flag;
+    bool has_matrix; // 是否写入 matrix_ndarray_dict
+    bool append;     // 列信息追加到已有项之后，否则覆盖
+    MatrixNdarray matrix;
+  };
+  std::vector<std::pair<std::string, std::string>> exp_rules;
+  VecS simple_vars;
+  std::vector<MatrixRecord> matrices;
+};
+
+// 一个矩阵的编码结果，先保存在内存中，再按固定顺序写入归档
+struct EncodedMatrix {
+  std::string name; // _<dict_id>_....bin
+  bool is_delta = false;
+  std::vector<std::vector<uint64_t>> columns;
+  // 尚未分配 id 的子 token：((columns 中的列, 行), 值)，按原先的登记顺序排列
+  std::vector<std::pair<std::pair<size_t, size_t>, std::string>>
+      pending_tokens;
+  std::string data;
+  std::chrono::steady_clock::duration elapsed{};
+  std::vector<ColumnCost> costs; // --codec-stats 时各列的编码估计
+};
+
 class LogParser {
 private:
   IndexMap<std::string, PatternContianer> sole_pat_dict;
   uint32_t raw_id_counter = 0;
   uint32_t parsed_id_counter = 0;
-  std::string output_dir;
   StrToU32 template_index;
+  // 模板指纹 -> parsed id，命中时不再拼接模板字符串
+  absl::flat_hash_map<uint64_t, uint32_t> fingerprint_index;
+  // 当前行的模板片段，指向本行或占位符常量
+  std::vector<std::string_view> template_parts;
+  // 上一行命中的时间戳格式，下一行先尝试它
+  size_t timestamp_hint = 0;
   const Args args;
+  // 本块各数字列的编码估计：(流名[列], 估计)，--codec-stats 时打印
+  std::vector<std::pair<std::string, ColumnCost>> column_costs;
 
   // absl::flat_hash_map<uint32_t, Statements> template_to_statement;
   void add_to_exp_rules_dict(const absl::flat_hash_set<VecS> &sole_pat_set,
-                             const std::string &value);
+                             const std::string &value, MinedPattern &mined);
   void add_to_matrix_ndarray_dict(const VecS &update_pat_vec,
                                   const absl::flat_hash_set<VecS> &sole_pat_set,
                                   const std::vector<size_t> &keep_column_idx,
                                   const std::string &final_pat_key,
-                                  Array2<std::string> &arr);
+                                  Array2<std::string> &arr,
+                                  MinedPattern &mined);
   void add_to_new_patterns(const VecS &update_pat_vec,
                            const VecS &all_unique_values, VecS &new_patterns,
                            VecS &new_pat_keys);
 
   bool should_use_delta_optimization(MatrixNdarray &matirx_ndarray);
+  // numbers 为若干对相邻行拼接后的数字，按对比较差值与原值的大小
   bool is_suitable_for_delta_encoding(const std::vector<uint64_t> &numbers);
 
 public:
-  std::vector<std::pair<VecS, uint32_t>> runtime_space;
+  RuntimeSpace runtime_space; // 每行的模板 id 与动态变量
   // std::vector<uint32_t> raw_to_parsed_map;
   U32ToStr parsed_log_map;
   StrToStr exp_rules_dict;
   DynamicSubTokenManager token_manager;
+  ChunkArchive archive; // 本块的全部输出流
   U32ToStr unmapped_templates_with_dict_id;
-  Pcre2Regex MAIN_TOKEN_RE, DYNAMIC_TOKEN_RE;
   std::vector<Pcre2Regex> CLASSIFY_PATTERNS;
   LogParser(const Args &args); // 构造函数创建独立的token管理器
-  void update_output_dir(const std::string &output_dir);
-  void process_chunk(const VecS &chunk, const IndexManager &index_manager,
-                     size_t chunk_idx);
-  void parse_one(const std::string &log);
-  size_t classify_and_process_token(std::string token, VecS &template_parts,
-                                    VecS &total_dynamic_vars);
+  void update_output_path(const std::string &output_path);
+  // 按流水线阶段拆分：解析 -> process_patterns_exp 挖掘 -> 编码
+  void parse_chunk(const LineSpans &chunk, const IndexManager &index_manager);
+  void encode_chunk();
+  void parse_one(std::string_view log);
+  // 返回 token 对应的占位符编号，-1 表示保留原文
+  int classify_and_process_token(std::string_view token);
   // bool parse_template(const std::string &log, uint32_t &parsed_id,
   //                     VecS &total_dynamic_vars);
-  bool parse_template_and_process_dynamic_vars(const std::string &log,
-                                               std::string &templ,
-                                               VecS &total_dynamic_vars);
+  // 动态变量直接追加到 runtime_space 的当前行，模板片段写入
+  // template_parts，并给出它们的指纹
+  bool parse_template_and_process_dynamic_vars(std::string_view log,
+                                               uint64_t &fingerprint);
 
-  bool process_dynamic_token(const std::string &token);
+  bool process_dynamic_token(std::string_view token);
   uint32_t manage_template(const std::string &templ);
+  uint32_t manage_template(uint64_t fingerprint);
   void process_patterns_exp();
+  // 只读取 container 与参数，结果写入 mined，可在多个线程中同时调用
+  void mine_sole_pattern(const std::string &sole_pat_key,
+                         PatternContianer &container, MinedPattern &mined);
+  void merge_mined_pattern(MinedPattern &mined);
   void generate_rules(const VecS &itemset, std::string &rules);
 
   void
@@ -78,11 +127,22 @@ public:
                         const VecS &representatives);
 
   void process_matrix_ndarray_dict();
-  void process_single_matrix(uint64_t dict_id, MatrixNdarray &matirx_ndarray);
+  void report_matrix_encode_time(std::vector<EncodedMatrix> &encoded);
+  void report_column_codecs();
+  // 以下三个函数只读取矩阵，结果写入 encoded，可在多个线程中同时调用
+  void process_single_matrix(uint64_t dict_id, MatrixNdarray &matirx_ndarray,
+                             EncodedMatrix &encoded);
   void process_matrix_with_delta_optimization(uint64_t dict_id,
-                                              MatrixNdarray &matirx_ndarray);
+                                              MatrixNdarray &matirx_ndarray,
+                                              EncodedMatrix &encoded);
+  // 整列都是长数字或十六进制时按原生整数追加到 columns（一或两列），
+  // 给出类型并返回 true；否则返回 false，不修改 columns
+  bool encode_typed_column(MatrixNdarray &matirx_ndarray, size_t col_idx,
+                           SubTokenType &type,
+                           std::vector<std::vector<uint64_t>> &columns);
   void process_single_matrix_original(uint64_t dict_id,
-                                      MatrixNdarray &matirx_ndarray);
+                                      MatrixNdarray &matirx_ndarray,
+                                      EncodedMatrix &encoded);
   void export_chunk_subtoken_dictionary();
   void export_unmapped_templates_with_dict_id_for_chunk();
 };
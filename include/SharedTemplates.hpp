@@ -0,0 +1,59 @@
+#ifndef LOGMD_SHAREDTEMPLATES_HPP
+#define LOGMD_SHAREDTEMPLATES_HPP
+
+#include "absl/container/flat_hash_map.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 跨块共享的模板字典，与 template.txt 格式相同（每行一个模板）。
+// 由第一块的模板建立或从之前的输出中载入，之后只读，可被多个线程同时查找。
+// 启用时各块 templateid.bin 中小于 size() 的 id 指向共享字典，
+// 其余 id 减去 size() 后指向块内的 template.txt
+class SharedTemplates {
+private:
+  std::vector<std::string> templates;
+  absl::flat_hash_map<std::string, uint32_t> index;
+
+public:
+  void load(std::string_view text) {
+    templates.clear();
+    index.clear();
+    size_t start = 0;
+    while (start < text.size()) {
+      size_t end = text.find('\n', start);
+      if (end == std::string_view::npos)
+        end = text.size();
+      auto &templ = templates.emplace_back(text.substr(start, end - start));
+      index.emplace(templ, uint32_t(templates.size() - 1));
+      start = end + 1;
+    }
+  }
+
+  std::string serialize() const {
+    std::string text;
+    for (auto &templ : templates) {
+      text += templ;
+      text += '\n';
+    }
+    return text;
+  }
+
+  size_t size() const { return templates.size(); }
+
+  bool find(const std::string &templ, uint32_t &id) const {
+    auto it = index.find(templ);
+    if (it == index.end())
+      return false;
+    id = it->second;
+    return true;
+  }
+};
+
+// 共享字典在输出中的流名：目录下为 shared.tar.*，容器中为共享区的流
+inline constexpr const char *SHARED_ARCHIVE_NAME = "shared";
+inline constexpr const char *SHARED_TEMPLATE_STREAM = "shared_template.txt";
+
+#endif // LOGMD_SHAREDTEMPLATES_HPP
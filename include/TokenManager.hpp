@@ -1,17 +1,23 @@
 #ifndef LOGMD_TOKENMANAGER_HPP
 #define LOGMD_TOKENMANAGER_HPP
 
+#include "ChunkArchive.hpp"
+#include "ColumnCodec.hpp"
 #include "utils/IndexMap.hpp"
+#include "utils/SubTokenType.hpp"
 #include <cstddef>
 #include <cstdint>
 #include <string>
 #include <typedef.hpp>
+#include <utility>
 #include <utils/IndexSet.hpp>
 #include <vector>
 
 class DynamicSubTokenManager {
 public:
   VecVecU64 num_subtoken_vec;
+  // 各格式的行首时间戳折算后的值，下标为格式编号，见 utils/Timestamp.hpp
+  VecVecU64 timestamp_vec;
   StrToU64 subtoken_to_id;
   U64ToStr id_to_subtoken;
   uint64_t string_counter = 0;
@@ -24,34 +30,95 @@ public:
                                       const int8_t init_flag, int8_t *flag,
                                       uint64_t *ret_id);
   uint64_t get_or_register_string(const std::string &token);
-  void process_base_dict_for_vec(const std::string &output_dir);
+  // 写出各长度的数字流与时间戳流，把 (流名, 编码估计) 追加到 costs。
+  // legacy 见 estimate_column
+  void process_base_dict_for_vec(
+      ChunkArchive &archive,
+      std::vector<std::pair<std::string, ColumnCost>> &costs, bool legacy);
   void process_simple_var_dict();
 };
 
+// 块内各个流的文件名，编码与解码共用
+inline constexpr const char *TEMPLATE_ID_STREAM = "templateid.bin";
+inline constexpr const char *TOKEN_ID_STREAM = "tokenid.bin";
+inline constexpr const char *TOKEN_DICT_STREAM = "token.txt";
+inline constexpr const char *TEMPLATE_DICT_STREAM = "template.txt";
+// --stream-vbyte 时 id 流改用 Stream VByte 编码，解码时优先于 .bin
+inline constexpr const char *TEMPLATE_ID_SVB_STREAM = "templateid.svb";
+inline constexpr const char *TOKEN_ID_SVB_STREAM = "tokenid.svb";
+
+struct ForFrame;
+
 class SubTokenCompressor {
 public:
+  // l<key1>_<key2>.bin：长度为 key1 的数字
+  static std::string base_binary_name(uint32_t key1, uint32_t key2);
+  // t<format>.bin：格式编号为 format 的行首时间戳
+  static std::string timestamp_name(uint32_t format);
+  // _<dict_id>_[delta_]<len>_<len>....bin：dict_id 对应模式的变量矩阵，
+  // len 为每一列的固定长度，-1 表示不定长；按原生整数存放的列在 len 前
+  // 加上类型字符，见 utils/SubTokenType.hpp。types 为空表示都是 TAGGED
+  static std::string matrix_name(uint64_t dict_id, bool is_delta,
+                                 const std::vector<int32_t> &lengths,
+                                 const std::vector<SubTokenType> &types = {});
+  // matrix_name 的逆过程，types 与 lengths 等长，不是矩阵流时返回 false
+  static bool parse_matrix_name(const std::string &name, uint64_t &dict_id,
+                                bool &is_delta, std::vector<int32_t> &lengths,
+                                std::vector<SubTokenType> &types);
+  // 读取一个 LEB128 整数并前移 cur，数据不完整时报错退出
+  static uint64_t read_unsigned_leb128(const char *&cur, const char *end);
+  static int64_t read_signed_leb128(const char *&cur, const char *end);
+  // 读取 write_bitpacked 写出的 n 个值追加到 out，返回之后的位置
+  static const char *read_bitpacked(const char *cur, const char *end,
+                                    size_t n, std::vector<uint64_t> &out);
+  // 读取整个 Stream VByte 流追加到 out，数据不完整时报错退出
+  static void read_stream_vbyte(const std::string &data,
+                                std::vector<uint32_t> &out);
+
   static bool calc_compression_mode(std::vector<int64_t> &nums);
   static std::vector<int64_t>
   compute_delta_values(const std::vector<uint64_t> &nums);
-  static void encode_and_store_base_binary(const std::string &output_dir,
-                                           const uint32_t key1,
-                                           const uint32_t key2,
-                                           const std::vector<uint64_t> &vec);
-  static void encode_and_store_trans_matrix_lsb(
-      const std::string &output_dir, const std::string &output_name,
+  // 返回各编码方式的估计大小与胜出者，vec 为空时不写出
+  static ColumnCost
+  encode_and_store_base_binary(ChunkArchive &archive, const uint32_t key1,
+                               const uint32_t key2,
+                               const std::vector<uint64_t> &vec,
+                               bool legacy = false);
+  // 时间戳按行递增且间隔相近，固定以 delta-of-delta 写出
+  static ColumnCost encode_and_store_timestamps(
+      ChunkArchive &archive, const uint32_t format,
+      const std::vector<uint64_t> &vec);
+  // 编码到内存中的 writer，可在多个线程中对不同矩阵同时调用。
+  // costs 不为空时按列追加各编码方式的估计（delta 优化的矩阵没有）
+  static void encode_trans_matrix_lsb(
+      std::string &writer, bool is_delta,
       const std::vector<std::vector<uint64_t>> &trans_num_matrix,
-      size_t expected_row_length);
+      size_t expected_row_length, std::vector<ColumnCost> *costs = nullptr,
+      bool legacy = false);
   static void
-  encode_and_store_template_id(const std::string &output_dir,
+  encode_and_store_template_id(ChunkArchive &archive,
                                const std::string &output_name,
                                const std::vector<uint32_t> &tmpl_ids);
-  static void write_unsigned_leb128(std::ofstream &writer, char *buff,
+  // Stream VByte 流：值的个数（LEB128）之后为控制字节与数据字节
+  static void
+  encode_and_store_template_id_svb(ChunkArchive &archive,
+                                   const std::string &output_name,
+                                   const std::vector<uint32_t> &tmpl_ids);
+  static void write_unsigned_leb128(std::string &writer, char *buff,
                                     size_t &offset, uint64_t value);
-  static void write_signed_leb128s(std::ofstream &writer,
+  // 帧（base 与 width）之后紧跟打包数据，值的个数由调用方记录
+  static void write_bitpacked(std::string &writer, char *buff, size_t &offset,
+                              const std::vector<uint64_t> &vec,
+                              ForFrame frame);
+  static void write_signed_leb128s(std::string &writer,
                                    const std::vector<int64_t> &nums);
   static void compress_chunk(const std::vector<uint8_t> &buffer,
-                             const std::string &output_path);
+                             const char *token_id_stream,
+                             ChunkArchive &archive, const Codec &codec);
   static void batch_encode_dynamic(const std::vector<uint64_t> &dynamic,
                                    std::vector<uint8_t> &buffer);
+  // 有 id 超过 32 位时返回 false，buffer 不变
+  static bool batch_encode_dynamic_svb(const std::vector<uint64_t> &dynamic,
+                                       std::vector<uint8_t> &buffer);
 };
 #endif // LOGMD_TOKENMANAGER_HPP
\ No newline at end of file
@@ -1,18 +1,47 @@
 #ifndef LOGMD_ARG_HPP
 #define LOGMD_ARG_HPP
 
+#include "Codec.hpp"
 #include <cstdlib>
 #include <iostream>
 #include <string>
 
 struct Args {
   std::string input_file;
+  // 压缩时为输出目录；解压时为输出文件，为空表示标准输出
   std::string output_dir;
   unsigned int chunk_size;
   unsigned int num_threads;
+  // 流水线各阶段的线程数，未指定时与 num_threads 相同
+  unsigned int parse_threads;
+  unsigned int mine_threads;
+  unsigned int encode_threads;
+  unsigned int archive_threads;
+  // 每个块内并行挖掘 sole pattern 的线程数，未指定时为 CPU 核数 / mine_threads
+  unsigned int mine_pattern_threads;
+  // 每个块内并行编码变量矩阵的线程数，未指定时为 CPU 核数 / encode_threads
+  unsigned int encode_matrix_threads;
   unsigned int rep_val_threshold;
   unsigned int zeta;
   double dom_ratio;
+  Codec codec;    // 归档使用的压缩器
+  bool container; // 所有块写入同一个 .lfa 容器文件
+  // 各块共用一个模板字典：由第一块建立，或从 template_dict 指定的
+  // 之前的输出（目录或 .lfa）中载入
+  bool shared_templates;
+  std::string template_dict;
+  // tokenid / templateid 改用 Stream VByte 编码，解码更快
+  bool stream_vbyte;
+  // 打印每个数字列选用的编码方式及各方式的估计大小
+  bool codec_stats;
+  // 只使用 decompression/ 下 Python 脚本能还原的编码：数字列只用 RAW 与
+  // DELTA，不折叠行首时间戳，矩阵列不按原生整数存放
+  bool python_compatible;
+  bool decompress; // -d：把 input_file 还原为原始日志
+  // --get / --count：只还原从第 get_line 行（从 1 开始）起的 get_count 行，
+  // get_line 为 0 表示未指定
+  unsigned long long get_line;
+  unsigned long long get_count;
   bool is_help;
 };
 
@@ -1,19 +1,42 @@
 #ifndef LOGMD_PROCESSOR_HPP
 #define LOGMD_PROCESSOR_HPP
 
+#include "ChunkArchive.hpp"
+#include "ChunkReader.hpp"
+#include "Container.hpp"
 #include "LogParser.hpp"
+#include "SharedTemplates.hpp"
+#include "TokenManager.hpp"
 #include "arg.hpp"
+#include "utils/LineSpans.hpp"
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
 void columnar_subtoken_compress_logs(const Args &args);
 
-// 处理日志块的函数
-void process_log_chunk(const VecS &logs, const IndexManager &im,
-                       size_t chunk_idx, const Args args);
+// 在流水线各阶段之间传递的块状态
+struct ChunkTask {
+  LogChunk chunk;
+  size_t line_count = 0;
+  std::unique_ptr<LogParser> parser;
+  ChunkArchive archive; // 编码完成后从 parser 移交过来
+  bool stream_vbyte = false; // id 流使用 Stream VByte 编码
+  std::vector<uint8_t> dynamic_buffer; // token id 流的内容
+  const char *token_id_stream = TOKEN_ID_STREAM;
+  const SharedTemplates *shared = nullptr; // 未启用共享模板时为空
+  std::chrono::steady_clock::time_point start_time;
+};
 
-// 读取文件函数
-void read_benchmark_file(VecS &lines, const std::string &filename);
+// 处理日志块的各阶段：解析 -> 挖掘 -> 编码 -> 打包压缩
+void parse_log_chunk(ChunkTask &task, const Args &args);
+void mine_log_chunk(ChunkTask &task);
+void encode_log_chunk(ChunkTask &task);
+// container 为 nullptr 时每块单独写出 <idx>.tar.xz
+void archive_log_chunk(ChunkTask &task, const Args &args,
+                       ContainerWriter *container);
 
-#endif // LOGMD_PROCESSOR_HPP
\ No newline at end of file
+#endif // LOGMD_PROCESSOR_HPP
@@ -0,0 +1,241 @@
+#ifndef LOGMD_ARENAFPGROWTH_HPP
+#define LOGMD_ARENAFPGROWTH_HPP
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// 把字符串项按首次出现的顺序编号为稠密 id。
+// 只保存 string_view，项的字节由调用方持有
+class FPItemIds {
+private:
+  absl::flat_hash_map<absl::string_view, uint32_t> index;
+  std::vector<std::string_view> items;
+
+public:
+  uint32_t add(std::string_view item) {
+    auto [it, inserted] = index.try_emplace(
+        absl::string_view(item.data(), item.size()), uint32_t(items.size()));
+    if (inserted)
+      items.push_back(item);
+    return it->second;
+  }
+
+  size_t size() const { return items.size(); }
+  std::string_view operator[](uint32_t id) const { return items[id]; }
+
+  // order[id] 为该项按字符串排序的名次，作为 ArenaFPGrowth 的次序
+  std::vector<uint32_t> order() const {
+    std::vector<uint32_t> ids(items.size()), order(items.size());
+    std::iota(ids.begin(), ids.end(), 0);
+    std::sort(ids.begin(), ids.end(),
+              [&](uint32_t a, uint32_t b) { return items[a] < items[b]; });
+    for (uint32_t rank = 0; rank < ids.size(); ++rank)
+      order[ids[rank]] = rank;
+    return order;
+  }
+};
+
+// 以稠密的 uint32 项 id 为输入的 FP-growth，挖掘结果与 FPGrowth 相同：
+// 项按频率降序、频率相同时按 item_order 升序排列（由 FPItemIds::order
+// 得到时即与 FPGrowth 的字符串比较一致），每个模式为条件模式 + 当前项。
+// 所有树（包括递归的条件 FP 树）的节点都分配在同一个 arena 中，
+// 条件树挖掘结束后整体回退；子节点与项头表链表都用下标表示
+class ArenaFPGrowth {
+public:
+  using Pattern = std::pair<std::vector<uint32_t>, uint32_t>;
+
+private:
+  static constexpr uint32_t NIL = UINT32_MAX;
+
+  struct Node {
+    uint32_t item; // 全局项 id
+    uint32_t count;
+    uint32_t parent;
+    uint32_t first_child;
+    uint32_t next_sibling;
+    uint32_t next_same; // 项头表链表中的下一个同项节点
+  };
+
+  // 带权事务，CSR 形式：第 i 条为 items[begin[i], begin[i + 1])
+  struct Transactions {
+    std::vector<uint32_t> items;
+    std::vector<uint32_t> begin{0};
+    std::vector<uint32_t> weights;
+
+    void clear() {
+      items.clear();
+      begin.assign(1, 0);
+      weights.clear();
+    }
+    size_t size() const { return weights.size(); }
+  };
+
+  // 一棵 FP 树：频繁项按排名存放，head[rank] 为该项的第一个节点
+  struct Tree {
+    uint32_t root;
+    std::vector<uint32_t> ranked_items;
+    std::vector<uint32_t> frequency;
+    std::vector<uint32_t> head;
+  };
+
+  uint32_t min_support;
+  Transactions input;
+  std::vector<Node> arena;
+  // 以全局项 id 为下标
+  std::vector<uint32_t> item_order, item_frequency, item_rank;
+  std::vector<Transactions> levels; // 每层递归复用的条件事务
+  std::vector<uint32_t> scratch, suffix;
+  std::vector<Pattern> patterns;
+
+  uint32_t new_node(uint32_t item, uint32_t count, uint32_t parent) {
+    arena.push_back({item, count, parent, NIL, NIL, NIL});
+    return uint32_t(arena.size() - 1);
+  }
+
+  void build_tree(const Transactions &trans, Tree &tree) {
+    // 1. 计算项频率，只记录并回收真正出现过的项
+    std::vector<uint32_t> touched;
+    for (size_t i = 0; i < trans.size(); ++i) {
+      for (uint32_t k = trans.begin[i]; k < trans.begin[i + 1]; ++k) {
+        uint32_t item = trans.items[k];
+        if (item_frequency[item] == 0)
+          touched.push_back(item);
+        item_frequency[item] += trans.weights[i];
+      }
+    }
+    for (uint32_t item : touched) {
+      if (item_frequency[item] >= min_support)
+        tree.ranked_items.push_back(item);
+    }
+    // 按频率降序、item_order 升序排名
+    std::sort(tree.ranked_items.begin(), tree.ranked_items.end(),
+              [&](uint32_t a, uint32_t b) {
+                auto fa = item_frequency[a], fb = item_frequency[b];
+                return fa != fb ? fa > fb : item_order[a] < item_order[b];
+              });
+    tree.frequency.reserve(tree.ranked_items.size());
+    for (uint32_t rank = 0; rank < tree.ranked_items.size(); ++rank) {
+      uint32_t item = tree.ranked_items[rank];
+      tree.frequency.push_back(item_frequency[item]);
+      item_rank[item] = rank;
+    }
+    for (uint32_t item : touched)
+      item_frequency[item] = 0;
+    tree.head.assign(tree.ranked_items.size(), NIL);
+
+    // 2. 过滤非频繁项，按排名排序后插入
+    tree.root = new_node(NIL, 0, NIL);
+    for (size_t i = 0; i < trans.size(); ++i) {
+      scratch.clear();
+      for (uint32_t k = trans.begin[i]; k < trans.begin[i + 1]; ++k) {
+        uint32_t rank = item_rank[trans.items[k]];
+        if (rank != NIL)
+          scratch.push_back(rank);
+      }
+      std::sort(scratch.begin(), scratch.end());
+      insert(tree, scratch, trans.weights[i]);
+    }
+    for (uint32_t item : tree.ranked_items)
+      item_rank[item] = NIL;
+  }
+
+  void insert(Tree &tree, const std::vector<uint32_t> &ranks,
+              uint32_t weight) {
+    uint32_t current = tree.root;
+    for (uint32_t rank : ranks) {
+      uint32_t item = tree.ranked_items[rank];
+      uint32_t child = arena[current].first_child;
+      while (child != NIL && arena[child].item != item)
+        child = arena[child].next_sibling;
+      if (child != NIL) {
+        arena[child].count += weight;
+      } else {
+        child = new_node(item, weight, current);
+        arena[child].next_sibling = arena[current].first_child;
+        arena[current].first_child = child;
+        arena[child].next_same = tree.head[rank];
+        tree.head[rank] = child;
+      }
+      current = child;
+    }
+  }
+
+  // 挖掘以 suffix 为后缀的模式；suffix 中越外层的项越靠前
+  void mine(const Tree &tree, size_t depth) {
+    for (uint32_t rank = 0; rank < tree.ranked_items.size(); ++rank) {
+      suffix.push_back(tree.ranked_items[rank]);
+      patterns.emplace_back(
+          std::vector<uint32_t>(suffix.rbegin(), suffix.rend()),
+          tree.frequency[rank]);
+      suffix.pop_back();
+    }
+
+    if (levels.size() <= depth)
+      levels.emplace_back();
+    for (uint32_t rank = 0; rank < tree.ranked_items.size(); ++rank) {
+      // 条件模式基：该项每个节点到根的前缀路径，权重为节点计数
+      auto &cond = levels[depth];
+      cond.clear();
+      for (uint32_t node = tree.head[rank]; node != NIL;
+           node = arena[node].next_same) {
+        size_t start = cond.items.size();
+        for (uint32_t p = arena[node].parent; p != tree.root;
+             p = arena[p].parent)
+          cond.items.push_back(arena[p].item);
+        if (cond.items.size() == start)
+          continue;
+        std::reverse(cond.items.begin() + start, cond.items.end());
+        cond.begin.push_back(uint32_t(cond.items.size()));
+        cond.weights.push_back(arena[node].count);
+      }
+      if (cond.size() == 0)
+        continue;
+
+      size_t mark = arena.size();
+      Tree cond_tree;
+      build_tree(cond, cond_tree);
+      suffix.push_back(tree.ranked_items[rank]);
+      mine(cond_tree, depth + 1);
+      suffix.pop_back();
+      arena.resize(mark);
+    }
+  }
+
+public:
+  explicit ArenaFPGrowth(uint32_t min_support) : min_support(min_support) {}
+
+  void reserve(size_t transactions, size_t items) {
+    input.items.reserve(items);
+    input.begin.reserve(transactions + 1);
+    input.weights.reserve(transactions);
+  }
+
+  void add_transaction(const uint32_t *items, size_t n, uint32_t weight = 1) {
+    input.items.insert(input.items.end(), items, items + n);
+    input.begin.push_back(uint32_t(input.items.size()));
+    input.weights.push_back(weight);
+  }
+
+  // 返回全部频繁项集及其支持度。order 以项 id 为下标，
+  // 大小即项 id 的上界
+  std::vector<Pattern> run(std::vector<uint32_t> order) {
+    item_order = std::move(order);
+    item_frequency.assign(item_order.size(), 0);
+    item_rank.assign(item_order.size(), NIL);
+    patterns.clear();
+    arena.clear();
+    Tree tree;
+    build_tree(input, tree);
+    mine(tree, 0);
+    return std::move(patterns);
+  }
+};
+
+#endif // LOGMD_ARENAFPGROWTH_HPP
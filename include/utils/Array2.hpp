@@ -1,8 +1,11 @@
 #ifndef LOGMD_ARRAY2_HPP
 #define LOGMD_ARRAY2_HPP
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 struct Array2Index {
@@ -112,17 +115,39 @@ public:
   size_t size() const { return _size; }
 };
 
+// 列式、字典编码的二维数组。每列的值按首次出现的顺序编号：
+// codes(j)[i] 为第 i 行在 values(j) 中的下标。构造时每格只哈希一次，
+// 之后的计数、去重与过滤都在连续的整数数组上进行。
+// 副本共享同一份只读数据，不再依赖构造时传入的行
 template <typename T> class Array2 {
 private:
-  std::vector<std::vector<T>> *data;
-  size_t row, col;
+  struct Column {
+    std::vector<uint32_t> codes;
+    std::vector<T> values;
+  };
+
+  std::shared_ptr<const std::vector<Column>> columns;
+  size_t row = 0, col = 0;
 
 public:
   Array2() = default;
-  Array2(std::vector<std::vector<T>> *arr) {
-    data = arr;
-    row = data->size();
-    col = data->front().size();
+  explicit Array2(const std::vector<std::vector<T>> &rows)
+      : row(rows.size()), col(rows.front().size()) {
+    auto data = std::make_shared<std::vector<Column>>(col);
+    absl::flat_hash_map<T, uint32_t> index;
+    for (size_t j = 0; j < col; ++j) {
+      auto &column = (*data)[j];
+      column.codes.reserve(row);
+      index.clear();
+      for (size_t i = 0; i < row; ++i) {
+        auto [it, inserted] =
+            index.try_emplace(rows[i][j], uint32_t(column.values.size()));
+        if (inserted)
+          column.values.push_back(rows[i][j]);
+        column.codes.push_back(it->second);
+      }
+    }
+    columns = std::move(data);
   }
 
   size_t get_row_count() const { return row; }
@@ -137,9 +162,34 @@ public:
   }
   RowIndex get_row(size_t row_idx) const { return RowIndex(row_idx, col); }
 
-  T &operator[](const Array2Index &idx) {
-    return (*data)[idx.row_idx][idx.col_idx];
+  const T &operator[](const Array2Index &idx) const {
+    auto &column = (*columns)[idx.col_idx];
+    return column.values[column.codes[idx.row_idx]];
+  }
+  uint32_t code(const Array2Index &idx) const {
+    return (*columns)[idx.col_idx].codes[idx.row_idx];
+  }
+  const std::vector<uint32_t> &codes(size_t col_idx) const {
+    return (*columns)[col_idx].codes;
+  }
+  const std::vector<T> &values(size_t col_idx) const {
+    return (*columns)[col_idx].values;
+  }
+
+  // 子矩阵第 j 列出现过的值的编号，按首次出现的顺序
+  std::vector<uint32_t> distinct_codes(SubArrayIndex &sub, size_t j) const {
+    size_t col_idx = sub.get(0, j).col_idx;
+    std::vector<bool> seen(values(col_idx).size(), false);
+    std::vector<uint32_t> result;
+    for (size_t i = 0; i < sub.get_row_count(); ++i) {
+      uint32_t c = code(sub.get(i, j));
+      if (!seen[c]) {
+        seen[c] = true;
+        result.push_back(c);
+      }
+    }
+    return result;
   }
 };
 
-#endif // LOGMD_ARRAY2_HPP
\ No newline at end of file
+#endif // LOGMD_ARRAY2_HPP
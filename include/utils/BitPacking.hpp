@@ -0,0 +1,27 @@
+#ifndef LOGMD_BITPACKING_HPP
+#define LOGMD_BITPACKING_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 帧参考（FOR）+ 位打包：每个值减去最小值 base 后，以统一的 width 位存放。
+// width 不超过 32 时，每 256 个值为一块，按 8 个 32 位通道交错存放
+// （第 k 个字的第 j 个通道存放第 k * 8 + j 个值的位），可用 SSE2/AVX2
+// 整块打包与解包；不足一块的尾部及 width 超过 32 时按顺序逐值紧密存放
+struct ForFrame {
+  uint64_t base = 0;
+  uint32_t width = 0;
+};
+
+// 覆盖 values 的最小帧
+ForFrame for_frame(const uint64_t *values, size_t n);
+// n 个值打包后的字节数
+size_t for_packed_size(size_t n, uint32_t width);
+// 追加 for_packed_size(n, frame.width) 字节到 out
+void for_pack(const uint64_t *values, size_t n, ForFrame frame,
+              std::string &out);
+// data 至少有 for_packed_size(n, frame.width) 字节
+void for_unpack(const char *data, size_t n, ForFrame frame, uint64_t *out);
+
+#endif // LOGMD_BITPACKING_HPP
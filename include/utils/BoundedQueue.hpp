@@ -0,0 +1,54 @@
+#ifndef LOGMD_BOUNDEDQUEUE_HPP
+#define LOGMD_BOUNDEDQUEUE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+// 有界阻塞队列：队列满时 push 阻塞，生产者因此不会跑到消费者前面太多
+template <class T> class BoundedQueue {
+private:
+  std::deque<T> data;
+  size_t capacity;
+  bool closed = false;
+  std::mutex mtx;
+  std::condition_variable not_full, not_empty;
+
+public:
+  explicit BoundedQueue(size_t capacity) : capacity(capacity ? capacity : 1) {}
+
+  // 禁用拷贝
+  BoundedQueue(const BoundedQueue &) = delete;
+  BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+  void push(T &&value) {
+    std::unique_lock<std::mutex> lock(mtx);
+    not_full.wait(lock, [this] { return data.size() < capacity || closed; });
+    data.emplace_back(std::move(value));
+    not_empty.notify_one();
+  }
+
+  // 队列关闭且已取空时返回 false
+  bool pop(T &value) {
+    std::unique_lock<std::mutex> lock(mtx);
+    not_empty.wait(lock, [this] { return !data.empty() || closed; });
+    if (data.empty())
+      return false;
+    value = std::move(data.front());
+    data.pop_front();
+    not_full.notify_one();
+    return true;
+  }
+
+  // 不再有新元素，唤醒所有等待的消费者
+  void close() {
+    std::lock_guard<std::mutex> lock(mtx);
+    closed = true;
+    not_empty.notify_all();
+    not_full.notify_all();
+  }
+};
+
+#endif // LOGMD_BOUNDEDQUEUE_HPP
@@ -0,0 +1,52 @@
+#ifndef LOGMD_LINESPANS_HPP
+#define LOGMD_LINESPANS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+// 行边界表：只记录每行在原始缓冲区中的起始偏移，按需返回 string_view，
+// 不为每行分配 std::string
+class LineSpans {
+private:
+  const char *base = nullptr;
+  // offsets[i] 为第 i 行起点，offsets[size()] 为末尾哨兵（含换行符）
+  std::vector<size_t> offsets;
+
+public:
+  LineSpans() = default;
+  LineSpans(const char *data, size_t size) { assign(data, size); }
+
+  // 一次扫描找出行边界（最多 max_lines 行），返回扫描消耗的字节数。
+  // 行为与 getline 一致：末尾没有换行符的最后一行同样计入，
+  // 末尾的换行符不产生空行
+  size_t assign(const char *data, size_t size,
+                size_t max_lines = SIZE_MAX) {
+    base = data;
+    offsets.clear();
+    offsets.reserve(std::min(max_lines, size / 64) + 2);
+    size_t pos = 0;
+    while (pos < size && offsets.size() < max_lines) {
+      offsets.push_back(pos);
+      auto nl =
+          static_cast<const char *>(std::memchr(data + pos, '\n', size - pos));
+      pos = nl ? size_t(nl - data) + 1 : size;
+    }
+    offsets.push_back(pos);
+    return pos;
+  }
+
+  std::string_view operator[](const size_t i) const {
+    size_t st = offsets[i], ed = offsets[i + 1];
+    if (ed > st && base[ed - 1] == '\n')
+      --ed;
+    return {base + st, ed - st};
+  }
+
+  size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+};
+
+#endif // LOGMD_LINESPANS_HPP
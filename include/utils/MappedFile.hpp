@@ -0,0 +1,81 @@
+#ifndef LOGMD_MAPPEDFILE_HPP
+#define LOGMD_MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <fcntl.h>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utils/util.hpp>
+
+// 只读内存映射文件，生命周期内保证映射有效
+class MappedFile {
+private:
+  const char *_data = nullptr;
+  size_t _size = 0;
+
+public:
+  MappedFile() = default;
+  explicit MappedFile(const std::string &filename) { open(filename); }
+
+  ~MappedFile() { close(); }
+
+  // 禁用拷贝
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  void open(const std::string &filename) {
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+      handle_error("Cannot open file: " + filename);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      ::close(fd);
+      handle_error("Cannot stat file: " + filename);
+    }
+    _size = st.st_size;
+    // 空文件无法 mmap，直接视为 0 行
+    if (_size == 0) {
+      ::close(fd);
+      return;
+    }
+
+    void *addr = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+      _size = 0;
+      handle_error("Cannot mmap file: " + filename);
+    }
+    madvise(addr, _size, MADV_SEQUENTIAL);
+    _data = static_cast<const char *>(addr);
+  }
+
+  void close() {
+    if (_data)
+      munmap(const_cast<char *>(_data), _size);
+    _data = nullptr;
+    _size = 0;
+  }
+
+  // 归还已处理区间占用的页（只释放完整落在区间内的页），
+  // 之后若再访问会从文件重新读入，因此并发读取相邻区间是安全的
+  void release(size_t offset, size_t length) const {
+    if (!_data || length == 0)
+      return;
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t st = (offset + page - 1) / page * page;
+    size_t ed = (offset + length) / page * page;
+    if (st < ed)
+      madvise(const_cast<char *>(_data) + st, ed - st, MADV_DONTNEED);
+  }
+
+  const char *data() const { return _data; }
+  size_t size() const { return _size; }
+  std::string_view view() const { return {_data, _size}; }
+};
+
+#endif // LOGMD_MAPPEDFILE_HPP
@@ -0,0 +1,34 @@
+#ifndef LOGMD_PARALLELFOR_HPP
+#define LOGMD_PARALLELFOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// 用 num_threads 个线程（包括调用线程）对 [0, n) 中每个下标调用 fn，
+// 下标按顺序动态领取，返回时全部完成。num_threads <= 1 时直接串行执行
+template <class Fn> void parallel_for(size_t n, size_t num_threads, Fn &&fn) {
+  num_threads = std::min(num_threads, n);
+  if (num_threads <= 1) {
+    for (size_t i = 0; i < n; ++i)
+      fn(i);
+    return;
+  }
+
+  std::atomic<size_t> next{0};
+  auto worker = [&] {
+    for (size_t i; (i = next.fetch_add(1)) < n;)
+      fn(i);
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  for (size_t i = 1; i < num_threads; ++i)
+    threads.emplace_back(worker);
+  worker();
+  for (auto &thread : threads)
+    thread.join();
+}
+
+#endif // LOGMD_PARALLELFOR_HPP
@@ -0,0 +1,93 @@
+#ifndef LOGMD_RUNTIMESPACE_HPP
+#define LOGMD_RUNTIMESPACE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 一个块内每行的模板 id 与动态变量。
+// 所有变量的字节连续存放在 arena 中，vars 记录每个变量的 (偏移, 长度)，
+// line_begin 为 CSR 形式的行偏移：第 i 行的变量为
+// vars[line_begin[i], line_begin[i + 1])。
+// 解析完成后输入行会被释放，因此变量仍需复制一份，但只有 arena 与 vars
+// 按倍数扩容，不再为每行分配 vector、为每个变量分配 string
+class RuntimeSpace {
+private:
+  struct Span {
+    uint64_t offset;
+    uint32_t length;
+  };
+
+  std::string arena;
+  std::vector<Span> vars;
+  std::vector<uint32_t> line_begin{0};
+  std::vector<uint32_t> template_ids;
+
+public:
+  // 第 i 行的变量，按出现顺序遍历得到 string_view
+  class Line {
+  private:
+    const char *base;
+    const Span *first, *last;
+
+  public:
+    class iterator {
+    private:
+      const char *base;
+      const Span *cur;
+
+    public:
+      iterator(const char *base, const Span *cur) : base(base), cur(cur) {}
+      std::string_view operator*() const {
+        return {base + cur->offset, cur->length};
+      }
+      iterator &operator++() {
+        ++cur;
+        return *this;
+      }
+      bool operator!=(const iterator &other) const { return cur != other.cur; }
+    };
+
+    Line(const char *base, const Span *first, const Span *last)
+        : base(base), first(first), last(last) {}
+    iterator begin() const { return {base, first}; }
+    iterator end() const { return {base, last}; }
+    size_t size() const { return last - first; }
+  };
+
+  void reserve(size_t lines) {
+    line_begin.reserve(lines + 1);
+    template_ids.reserve(lines);
+  }
+
+  // 向当前（尚未结束的）行追加一个变量
+  void add_var(std::string_view var) {
+    vars.push_back({arena.size(), uint32_t(var.size())});
+    arena.append(var);
+  }
+  // 结束当前行
+  void finish_line(uint32_t template_id) {
+    line_begin.push_back(uint32_t(vars.size()));
+    template_ids.push_back(template_id);
+  }
+  // 丢弃当前行已追加的变量
+  void drop_line() {
+    auto begin = line_begin.back();
+    if (begin < vars.size()) {
+      arena.resize(vars[begin].offset);
+      vars.resize(begin);
+    }
+  }
+
+  size_t size() const { return template_ids.size(); }
+  size_t var_count() const { return vars.size(); }
+  uint32_t template_id(size_t i) const { return template_ids[i]; }
+  Line line(size_t i) const {
+    return {arena.data(), vars.data() + line_begin[i],
+            vars.data() + line_begin[i + 1]};
+  }
+};
+
+#endif // LOGMD_RUNTIMESPACE_HPP
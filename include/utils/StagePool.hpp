@@ -0,0 +1,77 @@
+#ifndef LOGMD_STAGEPOOL_HPP
+#define LOGMD_STAGEPOOL_HPP
+
+#include "utils/BoundedQueue.hpp"
+#include "utils/WorkerStats.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// 流水线中的一个阶段：num_threads 个线程从 in 取任务，处理后放入 out。
+// in 关闭并取空后，最后一个退出的线程负责关闭 out，让下游阶段依次结束
+template <class T> class StagePool {
+private:
+  std::string name;
+  std::vector<std::thread> workers;
+  std::vector<WorkerStats> stats;
+  std::atomic<size_t> running{0};
+  std::chrono::steady_clock::time_point start_time, end_time;
+
+public:
+  StagePool(std::string name, size_t num_threads)
+      : name(std::move(name)), stats(num_threads ? num_threads : 1) {}
+
+  // 禁用拷贝
+  StagePool(const StagePool &) = delete;
+  StagePool &operator=(const StagePool &) = delete;
+
+  ~StagePool() { join(); }
+
+  // out 为 nullptr 表示这是最后一个阶段
+  template <class Fn>
+  void start(BoundedQueue<T> &in, BoundedQueue<T> *out, Fn fn) {
+    start_time = std::chrono::steady_clock::now();
+    running = stats.size();
+    for (size_t i = 0; i < stats.size(); ++i) {
+      workers.emplace_back([this, &in, out, fn, &ws = stats[i]] {
+        namespace chr = std::chrono;
+        T task;
+        auto t0 = chr::steady_clock::now();
+        while (in.pop(task)) {
+          auto t1 = chr::steady_clock::now();
+          ws.idle += t1 - t0;
+          fn(task);
+          t0 = chr::steady_clock::now();
+          ws.busy += t0 - t1;
+          ++ws.tasks;
+          if (out)
+            out->push(std::move(task));
+        }
+        ws.idle += chr::steady_clock::now() - t0;
+        if (--running == 0) {
+          end_time = chr::steady_clock::now();
+          if (out)
+            out->close();
+        }
+      });
+    }
+  }
+
+  void join() {
+    for (auto &worker : workers) {
+      if (worker.joinable())
+        worker.join();
+    }
+    workers.clear();
+  }
+
+  void report(std::ostream &os = std::cout) const {
+    report_worker_stats(name, stats, end_time - start_time, os);
+  }
+};
+
+#endif // LOGMD_STAGEPOOL_HPP
@@ -0,0 +1,18 @@
+#ifndef LOGMD_STREAMVBYTE_HPP
+#define LOGMD_STREAMVBYTE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Stream VByte：每个 32 位值按 1~4 个小端字节存放，长度减一作为 2 位控制码。
+// 前 (n + 3) / 4 个字节为控制流（第 i 个值的控制码位于第 i / 4 个字节的
+// 第 i % 4 * 2 位起），之后为数据流。控制码与数据分开存放，
+// 每 4 个值可用一次 SSSE3 字节重排完成编码或解码
+inline size_t svb_max_size(size_t n) { return (n + 3) / 4 + n * 4; }
+
+// out 至少有 svb_max_size(n) 字节，返回写出的字节数
+size_t svb_encode(const uint32_t *in, size_t n, uint8_t *out);
+// 从 size 字节中解码 n 个值，数据不完整时返回 false
+bool svb_decode(const uint8_t *in, size_t size, size_t n, uint32_t *out);
+
+#endif // LOGMD_STREAMVBYTE_HPP
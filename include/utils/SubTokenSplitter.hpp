@@ -0,0 +1,87 @@
+#ifndef LOGMD_SUBTOKENSPLITTER_HPP
+#define LOGMD_SUBTOKENSPLITTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// 按字母数字（\p{L}\p{N}）与其它字符把 token 切成交替的段，
+// 与 DYNAMIC_TOKEN_RE ([\p{L}\p{N}]+)|([^\p{L}\p{N}]+) 的结果一致
+
+// 非 ASCII 码位是否属于 \p{L} 或 \p{N}，结果按线程缓存
+bool is_unicode_alnum(uint32_t code_point);
+
+namespace sub_token_detail {
+
+enum CharClass : uint8_t { OTHER = 0, ALNUM = 1, NON_ASCII = 2 };
+
+// ASCII 字符直接查表，>= 0x80 的字节交给 UTF-8 慢路径
+struct CharClassTable {
+  uint8_t cls[256];
+  constexpr CharClassTable() : cls() {
+    for (int c = 0; c < 256; ++c) {
+      if (c >= 0x80)
+        cls[c] = NON_ASCII;
+      else if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+               (c >= 'A' && c <= 'Z'))
+        cls[c] = ALNUM;
+      else
+        cls[c] = OTHER;
+    }
+  }
+};
+inline constexpr CharClassTable CHAR_CLASS{};
+
+// 解码 cur 处的 UTF-8 字符，返回其字节数并给出类别。
+// 非法序列按单字节的非字母数字处理
+inline size_t classify_utf8(const unsigned char *cur, const unsigned char *end,
+                            bool &is_alnum) {
+  unsigned char c = cur[0];
+  size_t len = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+  is_alnum = false;
+  if (len == 1 || c > 0xF4 || size_t(end - cur) < len)
+    return 1;
+  uint32_t cp = c & (0x7F >> len);
+  for (size_t i = 1; i < len; ++i) {
+    if ((cur[i] & 0xC0) != 0x80)
+      return 1;
+    cp = (cp << 6) | (cur[i] & 0x3F);
+  }
+  // 过长编码、代理区与超出范围的码位
+  static constexpr uint32_t MIN_CODE_POINT[5] = {0, 0, 0x80, 0x800, 0x10000};
+  if (cp < MIN_CODE_POINT[len] || cp > 0x10FFFF ||
+      (cp >= 0xD800 && cp <= 0xDFFF))
+    return 1;
+  is_alnum = is_unicode_alnum(cp);
+  return len;
+}
+
+} // namespace sub_token_detail
+
+// 依次对每个段调用 fn(std::string_view run, bool is_alnum)，不复制数据。
+// 纯 ASCII 的 token 只查表，不解码
+template <class Fn> void split_sub_tokens(std::string_view token, Fn &&fn) {
+  using namespace sub_token_detail;
+  auto *begin = reinterpret_cast<const unsigned char *>(token.data());
+  auto *end = begin + token.size(), *cur = begin, *run = begin;
+  bool run_alnum = false;
+  while (cur < end) {
+    uint8_t cls = CHAR_CLASS.cls[*cur];
+    bool is_alnum = cls == ALNUM;
+    size_t len = 1;
+    if (cls == NON_ASCII)
+      len = classify_utf8(cur, end, is_alnum);
+    if (cur != run && is_alnum != run_alnum) {
+      fn(std::string_view(reinterpret_cast<const char *>(run), cur - run),
+         run_alnum);
+      run = cur;
+    }
+    run_alnum = is_alnum;
+    cur += len;
+  }
+  if (end != run)
+    fn(std::string_view(reinterpret_cast<const char *>(run), end - run),
+       run_alnum);
+}
+
+#endif // LOGMD_SUBTOKENSPLITTER_HPP
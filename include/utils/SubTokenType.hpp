@@ -0,0 +1,43 @@
+#ifndef LOGMD_SUBTOKENTYPE_HPP
+#define LOGMD_SUBTOKENTYPE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// 变量矩阵中整列同类型的子 token 按原生整数存放，不再登记为字符串。
+// 类型字符写在矩阵名中该列的长度之前，例如 _12_3_x32_u-1.bin
+enum class SubTokenType : char {
+  TAGGED = 0,      // 原有的 (数字 * 2) 或 (子 token id * 2 + 1)
+  DECIMAL = 'u',   // 无前导零、超过 15 位的十进制，最多 19 位
+  HEX_LOWER = 'x', // 定长的小写十六进制，4 ~ 32 位
+  HEX_UPPER = 'X', // 定长的大写十六进制，4 ~ 32 位
+};
+
+// 一个子 token 占用的值的个数：超过 16 位的十六进制拆成高低两个值
+inline size_t sub_token_slots(SubTokenType type, size_t width) {
+  return type != SubTokenType::DECIMAL && width > 16 ? 2 : 1;
+}
+
+// 对一列中出现过的每个子 token 调用 add，再由 type 给出整列可用的类型
+class SubTokenTypeDetector {
+private:
+  bool decimal = true, lower = true, upper = true;
+  bool has_lower = false, has_upper = false; // 含 a-f / A-F
+  size_t min_len = SIZE_MAX, max_len = 0;
+
+public:
+  void add(std::string_view run);
+  SubTokenType type() const;
+  // 十六进制的位数，即该列的定长
+  size_t width() const { return max_len; }
+};
+
+// 按 type 把 run 解析为 sub_token_slots 个值，高位在前
+void parse_sub_token(std::string_view run, SubTokenType type, uint64_t *out);
+// parse_sub_token 的逆过程，width 为十六进制的位数
+void append_sub_token(std::string &out, SubTokenType type, size_t width,
+                      const uint64_t *values);
+
+#endif // LOGMD_SUBTOKENTYPE_HPP
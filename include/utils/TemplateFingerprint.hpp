@@ -0,0 +1,39 @@
+#ifndef LOGMD_TEMPLATEFINGERPRINT_HPP
+#define LOGMD_TEMPLATEFINGERPRINT_HPP
+
+#include "absl/hash/hash.h"
+#include "absl/strings/string_view.h"
+#include <cstdint>
+#include <string_view>
+
+// 模板的流式指纹：按顺序混入每个静态片段的哈希与占位符编号，
+// 不拼接模板字符串。相同的片段序列得到相同的指纹；
+// 指纹相同不代表模板相同，命中后仍需逐段比对
+class TemplateFingerprint {
+private:
+  uint64_t state = 0x9E3779B97F4A7C15ULL;
+
+  // murmur3 的 fmix64
+  static uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+public:
+  void add_literal(std::string_view part) {
+    uint64_t h = absl::Hash<absl::string_view>{}(
+        absl::string_view(part.data(), part.size()));
+    state = mix(state * 31 + h);
+  }
+  // 占位符编号与字面片段的哈希可能相同，混入前先与字面量区分开
+  void add_placeholder(uint32_t code) {
+    state = mix((state ^ 0xA5A5A5A5A5A5A5A5ULL) * 31 + code);
+  }
+  uint64_t value() const { return state; }
+};
+
+#endif // LOGMD_TEMPLATEFINGERPRINT_HPP
@@ -0,0 +1,25 @@
+#ifndef LOGMD_TIMESTAMP_HPP
+#define LOGMD_TIMESTAMP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// 行首时间戳的识别与还原。
+// 识别出的时间戳折算为一个整数：自 1970-01-01 起的秒数乘以 10^小数位数，
+// 再加上小数部分；没有年份的格式按 2000 年（闰年）折算。
+// 格式编号写在模板的 <t编号> 中并作为流名的一部分，只能在末尾追加
+
+// 已知格式的个数，格式见 timestamp.cpp 中的 FORMATS
+size_t timestamp_format_count();
+
+// line 以已知格式的时间戳开头、且其后不是数字时返回格式编号，
+// length 为时间戳的字节数，value 为折算后的值；否则返回 -1。
+// 先尝试 hint 对应的格式，通常是上一行命中的格式
+int match_timestamp(std::string_view line, size_t hint, size_t &length,
+                    int64_t &value);
+// match_timestamp 的逆过程，按格式把 value 追加到 out
+void append_timestamp(std::string &out, size_t format, int64_t value);
+
+#endif // LOGMD_TIMESTAMP_HPP
@@ -0,0 +1,31 @@
+#ifndef LOGMD_TOKENCLASSIFIER_HPP
+#define LOGMD_TOKENCLASSIFIER_HPP
+
+#include <cstddef>
+#include <string_view>
+
+// 一次扫描得到的 token 字符类别
+struct TokenCharFlags {
+  bool has_digit = false; // 含 ASCII 数字
+  bool all_digit = false; // 非空且全部为 ASCII 数字，即 is_numeric
+  bool has_alpha = false; // 含 ASCII 字母
+  bool has_punct = false; // 含非字母数字的字节（包括非 ASCII 字节）
+  bool has_slash = false; // 含 /
+  bool non_ascii = false; // 含 >= 0x80 的字节
+};
+
+// x86 上每次用 SSE2 检查 16 字节，其它平台查表
+TokenCharFlags classify_token_chars(std::string_view token);
+
+// 是否含有 Windows 路径开头，即 CLASSIFY_PATTERNS 中的 [a-zA-Z]:\\ 部分
+inline bool has_drive_path(std::string_view token) {
+  for (size_t pos = token.find(":\\", 1); pos != std::string_view::npos;
+       pos = token.find(":\\", pos + 1)) {
+    char c = token[pos - 1];
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+      return true;
+  }
+  return false;
+}
+
+#endif // LOGMD_TOKENCLASSIFIER_HPP
@@ -0,0 +1,70 @@
+#ifndef LOGMD_TOKENSPLITTER_HPP
+#define LOGMD_TOKENSPLITTER_HPP
+
+#include <cstddef>
+#include <string_view>
+
+// 按空白字符与 | 切分一行，与 MAIN_TOKEN_RE ([^\s|]+)|(\s)|(\|) 的结果一致：
+// 连续的非分隔符为一个 token，每个分隔符单独为一个 token。
+// 正则以 UTF + UCP 编译，\s 还包括 U+0085、U+00A0、U+2000 等 Unicode 空白
+
+// 返回 [cur, end) 中第一个可能是分隔符的字节（ASCII 空白、|，
+// 或 Unicode 分隔符的首字节），没有时返回 end。
+// 按 CPU 支持情况使用 AVX2 / SSE2 / 标量实现
+const char *find_token_delim(const char *cur, const char *end);
+
+// cur 处分隔符的字节长度，不是分隔符时返回 0
+inline size_t token_delim_length(const char *cur, const char *end) {
+  auto c = static_cast<unsigned char>(*cur);
+  if (c == ' ' || c == '|' || (c >= '\t' && c <= '\r'))
+    return 1;
+  size_t left = end - cur;
+  auto at = [cur](size_t i) { return static_cast<unsigned char>(cur[i]); };
+  switch (c) {
+  case 0xC2: // U+0085、U+00A0
+    return left >= 2 && (at(1) == 0x85 || at(1) == 0xA0) ? 2 : 0;
+  case 0xE1: // U+1680、U+180E
+    if (left < 3)
+      return 0;
+    return (at(1) == 0x9A && at(2) == 0x80) || (at(1) == 0xA0 && at(2) == 0x8E)
+               ? 3
+               : 0;
+  case 0xE2:
+    if (left < 3)
+      return 0;
+    // U+2000 ~ U+200A、U+2028、U+2029、U+202F
+    if (at(1) == 0x80 && ((at(2) >= 0x80 && at(2) <= 0x8A) || at(2) == 0xA8 ||
+                          at(2) == 0xA9 || at(2) == 0xAF))
+      return 3;
+    // U+205F
+    return at(1) == 0x81 && at(2) == 0x9F ? 3 : 0;
+  case 0xE3: // U+3000
+    return left >= 3 && at(1) == 0x80 && at(2) == 0x80 ? 3 : 0;
+  default:
+    return 0;
+  }
+}
+
+// 依次对每个 token 调用 fn(std::string_view)，不复制数据
+template <class Fn> void split_tokens(std::string_view line, Fn &&fn) {
+  const char *cur = line.data(), *end = cur + line.size(), *run = cur;
+  while (cur < end) {
+    const char *pos = find_token_delim(cur, end);
+    if (pos == end)
+      break;
+    size_t len = token_delim_length(pos, end);
+    if (len == 0) {
+      // 以同一字节开头的其它多字节字符
+      cur = pos + 1;
+      continue;
+    }
+    if (pos > run)
+      fn(std::string_view(run, pos - run));
+    fn(std::string_view(pos, len));
+    cur = run = pos + len;
+  }
+  if (end > run)
+    fn(std::string_view(run, end - run));
+}
+
+#endif // LOGMD_TOKENSPLITTER_HPP
@@ -0,0 +1,47 @@
+#ifndef LOGMD_WORKERSTATS_HPP
+#define LOGMD_WORKERSTATS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// 单个工作线程的忙闲统计：busy 为处理任务的时间，idle 为等待任务的时间
+struct WorkerStats {
+  size_t tasks = 0;
+  std::chrono::steady_clock::duration busy{0};
+  std::chrono::steady_clock::duration idle{0};
+};
+
+// 打印每个线程的忙闲时间，以及与理想均衡情况相比的完工时间
+inline void report_worker_stats(const std::string &name,
+                                const std::vector<WorkerStats> &stats,
+                                std::chrono::steady_clock::duration makespan,
+                                std::ostream &os = std::cout) {
+  namespace chr = std::chrono;
+  auto ms = [](chr::steady_clock::duration d) {
+    return chr::duration_cast<chr::milliseconds>(d).count();
+  };
+
+  chr::steady_clock::duration total_busy{0};
+  for (size_t i = 0; i < stats.size(); ++i) {
+    auto &s = stats[i];
+    auto all = s.busy + s.idle;
+    double util = all.count() ? 100.0 * s.busy.count() / all.count() : 0.0;
+    os << name << " thread " << i << ": " << s.tasks << " tasks, busy "
+       << ms(s.busy) << "ms, idle " << ms(s.idle) << "ms (" << std::fixed
+       << std::setprecision(1) << util << "% busy)" << std::defaultfloat
+       << std::endl;
+    total_busy += s.busy;
+  }
+  if (stats.empty())
+    return;
+  // 所有线程完全均衡时的完工时间下界
+  auto ideal = total_busy / stats.size();
+  os << name << " makespan: " << ms(makespan) << "ms, balanced bound "
+     << ms(ideal) << "ms" << std::endl;
+}
+
+#endif // LOGMD_WORKERSTATS_HPP
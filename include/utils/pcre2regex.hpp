@@ -5,7 +5,9 @@
 #include <cstddef>
 #include <memory>
 #include <pcre2.h>
+#include <sstream>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <utils/util.hpp>
 #include <vector>
@@ -71,10 +73,10 @@ public:
   // 禁用拷贝
   Pcre2RegexIterator(const Pcre2RegexIterator &) = delete;
   Pcre2RegexIterator &operator=(const Pcre2RegexIterator &) = delete;
-  Pcre2RegexIterator(const std::string &subject, pcre2_code *code,
+  Pcre2RegexIterator(std::string_view subject, pcre2_code *code,
                      pcre2_match_data *match_data,
                      pcre2_match_context *match_context)
-      : c_str(reinterpret_cast<PCRE2_SPTR>(subject.c_str())),
+      : c_str(reinterpret_cast<PCRE2_SPTR>(subject.data())),
         length(subject.length()), start_offset(0), code(code),
         match_data(match_data), match_context(match_context), is_end(false) {
     // if (start_offset >= length)
@@ -201,13 +203,13 @@ public:
   }
 
   // 匹配操作
-  bool match(const std::string &subject, uint32_t options = 0) const {
+  bool match(std::string_view subject, uint32_t options = 0) const {
     pcre2_match_data *match_data =
         pcre2_match_data_create_from_pattern(code_, nullptr);
     if (!match_data)
       handle_error("Match data creation failed");
 
-    int rc = pcre2_match(code_, reinterpret_cast<PCRE2_SPTR>(subject.c_str()),
+    int rc = pcre2_match(code_, reinterpret_cast<PCRE2_SPTR>(subject.data()),
                          subject.length(),
                          0, // start offset
                          options, match_data, match_context_);
@@ -253,7 +255,7 @@ public:
     return matches;
   }
 
-  Pcre2RegexIterator get_iter(const std::string &subject) {
+  Pcre2RegexIterator get_iter(std::string_view subject) {
     auto match_data = pcre2_match_data_create_from_pattern(code_, nullptr);
     return Pcre2RegexIterator(subject, code_, match_data, match_context_);
   }
@@ -5,10 +5,11 @@
 #include <cstddef>
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <sys/types.h>
 #include <vector>
 
-bool is_numeric(const std::string &);
+bool is_numeric(std::string_view);
 std::string format(const std::string format_str, ...);
 // 错误处理函数
 void handle_error(const std::string &message, int exit_code = 1);
@@ -1,15 +1,33 @@
 #include "arg.hpp"
 #include "utils/util.hpp"
+#include <algorithm>
 #include <string>
+#include <thread>
 Args parse_args(int argc, char *argv[]) {
   Args args = {
       .input_file = "",
-      .output_dir = "./output",
+      .output_dir = "",
       .chunk_size = 100000,
       .num_threads = 4,
+      .parse_threads = 0,
+      .mine_threads = 0,
+      .encode_threads = 0,
+      .archive_threads = 0,
+      .mine_pattern_threads = 0,
+      .encode_matrix_threads = 0,
       .rep_val_threshold = 40,
       .zeta = 3,
       .dom_ratio = 0.6,
+      .codec = Codec(),
+      .container = false,
+      .shared_templates = false,
+      .template_dict = "",
+      .stream_vbyte = false,
+      .codec_stats = false,
+      .python_compatible = false,
+      .decompress = false,
+      .get_line = 0,
+      .get_count = 1,
       .is_help = false,
   };
 
@@ -18,13 +36,49 @@ Args parse_args(int argc, char *argv[]) {
     if (arg == "-h" || arg == "--help") {
       std::cout
           << "Usage: " << argv[0] << " [options] [file]\n"
+          << "       " << argv[0] << " -d [-o <file>] [-t <integer>] input\n"
+          << "       " << argv[0]
+          << " --get <line> [--count <n>] [-o <file>] input\n"
+          << "  file          input log file, FIFO, or - for stdin\n"
+          << "  input         output directory, .lfa container or one\n"
+          << "                <idx>.tar* chunk archive\n"
           << "Options:\n"
+          << "  -d            decompress input to -o <file> (default stdout)\n"
+          << "  --get <line>  only restore line <line> (1-based) of input\n"
+          << "  --count <n>   with --get, restore <n> lines (default 1)\n"
           << "  -o <dir>      Set output directory (default ./output)\n"
           << "  -c <integer>  Chunk size (default 100000)\n"
           << "  -t <integer>  num of threads (default 4)\n"
+          << "  -tp <integer> num of parse threads (default: -t)\n"
+          << "  -tm <integer> num of pattern mining threads (default: -t)\n"
+          << "  -te <integer> num of encode threads (default: -t)\n"
+          << "  -ta <integer> num of archive (xz) threads (default: -t)\n"
+          << "  -tmp <integer> threads mining the patterns of one chunk\n"
+          << "                (default: cores / -tm)\n"
+          << "  -tem <integer> threads encoding the matrices of one chunk\n"
+          << "                (default: cores / -te)\n"
           << "  -rt <integer> representative value threshold (default 40)\n"
           << "  -dt <float>   dominance ratio threshold (default 0.6)\n"
-          << "  -z <integer>  zeta (default 3)\n";
+          << "  -z <integer>  zeta (default 3)\n"
+          << "  --codec <spec> archive codec (default xz:6e):\n"
+          << "                store | xz[:0-9[e]] | zstd[:1-22[:long[=N]]]\n"
+          << "  --container   write all chunks into one seekable <dir>/"
+          << "logfold.lfa\n"
+          << "                instead of one <idx>.tar.xz per chunk\n"
+          << "  --shared-templates\n"
+          << "                share one template dictionary, built from the\n"
+          << "                first chunk, across all chunks\n"
+          << "  --template-dict <input>\n"
+          << "                share the template dictionary of a previous\n"
+          << "                --shared-templates output (directory or .lfa)\n"
+          << "  --stream-vbyte\n"
+          << "                store token and template ids with Stream VByte\n"
+          << "                instead of LEB128 (faster to decompress)\n"
+          << "  --codec-stats print the codec chosen for every numeric column\n"
+          << "                and the estimated size of each candidate\n"
+          << "  --python-compatible\n"
+          << "                only use encodings that the decompression/*.py\n"
+          << "                scripts can restore\n";
       args.is_help = true;
     } else if (arg == "-o" && i + 1 < argc) {
       args.output_dir = argv[++i]; // 跳过下一个参数（文件名）
@@ -32,6 +86,18 @@ Args parse_args(int argc, char *argv[]) {
       args.chunk_size = std::stoul(argv[++i]); // 跳过下一个参数（文件名）
     } else if (arg == "-t" && i + 1 < argc) {
       args.num_threads = std::stoul(argv[++i]); // 跳过下一个参数（文件名）
+    } else if (arg == "-tp" && i + 1 < argc) {
+      args.parse_threads = std::stoul(argv[++i]);
+    } else if (arg == "-tm" && i + 1 < argc) {
+      args.mine_threads = std::stoul(argv[++i]);
+    } else if (arg == "-te" && i + 1 < argc) {
+      args.encode_threads = std::stoul(argv[++i]);
+    } else if (arg == "-ta" && i + 1 < argc) {
+      args.archive_threads = std::stoul(argv[++i]);
+    } else if (arg == "-tmp" && i + 1 < argc) {
+      args.mine_pattern_threads = std::stoul(argv[++i]);
+    } else if (arg == "-tem" && i + 1 < argc) {
+      args.encode_matrix_threads = std::stoul(argv[++i]);
     } else if (arg == "-rt" && i + 1 < argc) {
       args.rep_val_threshold =
           std::stoul(argv[++i]); // 跳过下一个参数（文件名）
@@ -39,15 +105,42 @@ Args parse_args(int argc, char *argv[]) {
       args.dom_ratio = std::stod(argv[++i]); // 跳过下一个参数（文件名）
     } else if (arg == "-z" && i + 1 < argc) {
       args.zeta = std::stoul(argv[++i]); // 跳过下一个参数（文件名）
+    } else if (arg == "-d") {
+      args.decompress = true;
+    } else if (arg == "--get" && i + 1 < argc) {
+      args.get_line = std::stoull(argv[++i]);
+      args.decompress = true;
+      if (args.get_line == 0)
+        handle_error("line number starts from 1");
+    } else if (arg == "--count" && i + 1 < argc) {
+      args.get_count = std::stoull(argv[++i]);
+    } else if (arg == "--container") {
+      args.container = true;
+    } else if (arg == "--shared-templates") {
+      args.shared_templates = true;
+    } else if (arg == "--template-dict" && i + 1 < argc) {
+      args.template_dict = argv[++i];
+      args.shared_templates = true;
+    } else if (arg == "--stream-vbyte") {
+      args.stream_vbyte = true;
+    } else if (arg == "--codec-stats") {
+      args.codec_stats = true;
+    } else if (arg == "--python-compatible") {
+      args.python_compatible = true;
+    } else if (arg == "--codec" && i + 1 < argc) {
+      args.codec = parse_codec(argv[++i]);
     } else {
       args.input_file = arg;
     }
   }
+  // 解压时 -o 为输出文件，不指定或为 - 时写到标准输出
+  if (args.output_dir.empty() && !args.decompress)
+    args.output_dir = "./output";
   if (args.is_help) {
     exit(0);
   } else if (args.input_file.empty()) {
     handle_error("input file not specified");
-  } else if (args.output_dir[0] == '-') {
+  } else if (!args.decompress && args.output_dir[0] == '-') {
     handle_error("invalid output directory: ");
   } else if (args.chunk_size <= 0) {
     handle_error("chunk size must be positive");
@@ -59,6 +152,21 @@ Args parse_args(int argc, char *argv[]) {
     handle_error("representative value threshold must be positive");
   } else if (args.dom_ratio <= 0 || args.dom_ratio >= 1) {
     handle_error("dominance ratio must be in the range (0, 1)");
+  } else if (args.python_compatible &&
+             (args.container || args.shared_templates || args.stream_vbyte)) {
+    handle_error("--python-compatible cannot be combined with --container, "
+                 "--shared-templates or --stream-vbyte");
   }
+  for (auto *stage_threads : {&args.parse_threads, &args.mine_threads,
+                              &args.encode_threads, &args.archive_threads}) {
+    if (*stage_threads == 0)
+      *stage_threads = args.num_threads;
+  }
+  // 同一阶段各块的块内线程合计大约占满所有核
+  unsigned int cores = std::thread::hardware_concurrency();
+  if (args.mine_pattern_threads == 0)
+    args.mine_pattern_threads = std::max(1u, cores / args.mine_threads);
+  if (args.encode_matrix_threads == 0)
+    args.encode_matrix_threads = std::max(1u, cores / args.encode_threads);
   return args;
 }
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "internal/out.hpp"
+#include <ChunkArchive.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utils/util.hpp>
+
+static constexpr size_t TAR_BLOCK_SIZE = 512;
+static constexpr size_t TAR_RECORD_SIZE = 20 * TAR_BLOCK_SIZE;
+
+// 以 NUL 结尾的八进制数字段
+static void write_octal(char *field, size_t width, uint64_t value) {
+  std::snprintf(field, width, "%0*llo", int(width - 1),
+                (unsigned long long)value);
+}
+
+// GNU tar 的长文件名：名字不少于 100 字节时，先写出一个 ././@LongLink
+// 条目（类型 L），数据为以 NUL 结尾的完整名字，之后的条目只保留前 99 字节
+static constexpr const char *TAR_LONG_LINK = "././@LongLink";
+
+static void append_header(std::string &tar, const std::string &name,
+                          uint64_t size, char type, std::time_t mtime) {
+  char header[TAR_BLOCK_SIZE] = {0};
+  std::memcpy(header, name.data(), std::min<size_t>(name.size(), 99));
+  write_octal(header + 100, 8, 0644);       // mode
+  write_octal(header + 108, 8, 0);          // uid
+  write_octal(header + 116, 8, 0);          // gid
+  write_octal(header + 124, 12, size);      // size
+  write_octal(header + 136, 12, mtime);     // mtime
+  header[156] = type;                       // 类型
+  std::memcpy(header + 257, "ustar", 6);    // magic
+  std::memcpy(header + 263, "00", 2);       // version
+
+  // 校验和计算时该字段按 8 个空格处理
+  std::memset(header + 148, ' ', 8);
+  uint32_t checksum = 0;
+  for (unsigned char c : header)
+    checksum += c;
+  std::snprintf(header + 148, 8, "%06o", checksum);
+  header[155] = ' ';
+  tar.append(header, TAR_BLOCK_SIZE);
+}
+
+static void append_data(std::string &tar, const char *data, size_t size) {
+  tar.append(data, size);
+  tar.append((TAR_BLOCK_SIZE - size % TAR_BLOCK_SIZE) % TAR_BLOCK_SIZE, '\0');
+}
+
+static size_t padded_size(size_t size) {
+  return (size + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE * TAR_BLOCK_SIZE;
+}
+
+std::string ChunkArchive::to_tar() {
+  std::string tar;
+  size_t total = TAR_RECORD_SIZE;
+  for (auto &[name, data] : entries()) {
+    total += TAR_BLOCK_SIZE + padded_size(data.size());
+    if (name.size() >= 100)
+      total += TAR_BLOCK_SIZE + padded_size(name.size() + 1);
+  }
+  tar.reserve(total);
+
+  auto mtime = std::time(nullptr);
+  for (auto &[name, data] : entries()) {
+    // 矩阵流 _<id>_<len>_....bin 的列多时名字会超过 ustar 的 100 字节
+    if (name.size() >= 100) {
+      append_header(tar, TAR_LONG_LINK, name.size() + 1, 'L', mtime);
+      append_data(tar, name.c_str(), name.size() + 1);
+    }
+    append_header(tar, name, data.size(), '0', mtime); // 普通文件
+    append_data(tar, data.data(), data.size());
+  }
+  // 两个全零块表示结束，再补齐到 tar 默认的记录大小
+  tar.append(2 * TAR_BLOCK_SIZE, '\0');
+  tar.append((TAR_RECORD_SIZE - tar.size() % TAR_RECORD_SIZE) %
+                 TAR_RECORD_SIZE,
+             '\0');
+  return tar;
+}
+
+ChunkArchive ChunkArchive::from_tar(const std::string &tar) {
+  ChunkArchive archive;
+  size_t pos = 0;
+  std::string long_name;
+  while (pos + TAR_BLOCK_SIZE <= tar.size()) {
+    const char *header = tar.data() + pos;
+    if (header[0] == '\0')
+      break; // 结束块
+    std::string name(header, strnlen(header, 100));
+    // ustar 的长文件名前缀
+    if (std::memcmp(header + 257, "ustar", 5) == 0 && header[345] != '\0')
+      name = std::string(header + 345, strnlen(header + 345, 155)) + "/" + name;
+    uint64_t size = std::strtoull(std::string(header + 124, 12).c_str(),
+                                  nullptr, 8);
+    pos += TAR_BLOCK_SIZE;
+    if (pos + size > tar.size())
+      handle_error("Truncated tar archive");
+
+    char type = header[156];
+    if (type == 'L') {
+      // GNU 长文件名，作用于下一个条目
+      long_name.assign(tar.data() + pos, strnlen(tar.data() + pos, size));
+    } else {
+      if (!long_name.empty())
+        name = std::move(long_name);
+      long_name.clear();
+      if (type == '0' || type == '\0') {
+        if (name.compare(0, 2, "./") == 0)
+          name.erase(0, 2);
+        archive.file(name).assign(tar.data() + pos, size);
+      }
+    }
+    pos += padded_size(size);
+  }
+  return archive;
+}
+
+void ChunkArchive::write(const Codec &codec) {
+  std::string compressed;
+  codec_compress(codec, to_tar(), compressed);
+
+  auto file_path = _path + codec_extension(codec);
+  std::ofstream writer(file_path, std::ios::binary);
+  if (!writer.is_open()) {
+    handle_error(format("Failed to create output file: %s", file_path.c_str()));
+  }
+  writer.write(compressed.data(), compressed.size());
+  writer.close();
+  if (!writer)
+    handle_error(format("Failed to write output file: %s", file_path.c_str()));
+}
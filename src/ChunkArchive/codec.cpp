@@ -0,0 +1,351 @@
+#include <Codec.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <lzma.h>
+#include <memory>
+#include <string>
+#include <utils/util.hpp>
+#include <vector>
+#include <zstd.h>
+
+// zstd --long 不指定窗口时的默认值
+static constexpr int ZSTD_DEFAULT_LONG_WINDOW_LOG = 27;
+
+static int parse_int(const std::string &text, const std::string &spec) {
+  size_t used = 0;
+  int value = 0;
+  try {
+    value = std::stoi(text, &used);
+  } catch (...) {
+    used = 0;
+  }
+  if (used == 0 || used != text.size())
+    handle_error("invalid codec: " + spec);
+  return value;
+}
+
+Codec parse_codec(const std::string &spec) {
+  std::vector<std::string> parts;
+  size_t start = 0, colon;
+  while ((colon = spec.find(':', start)) != std::string::npos) {
+    parts.push_back(spec.substr(start, colon - start));
+    start = colon + 1;
+  }
+  parts.push_back(spec.substr(start));
+
+  Codec codec;
+  auto &name = parts[0];
+  if (name == "store") {
+    if (parts.size() != 1)
+      handle_error("invalid codec: " + spec);
+    codec.type = CodecType::STORE;
+    codec.level = 0;
+    codec.extreme = false;
+  } else if (name == "xz") {
+    if (parts.size() > 2)
+      handle_error("invalid codec: " + spec);
+    if (parts.size() == 2) {
+      auto level = parts[1];
+      codec.extreme = !level.empty() && level.back() == 'e';
+      if (codec.extreme)
+        level.pop_back();
+      codec.level = parse_int(level, spec);
+    }
+    if (codec.level < 0 || codec.level > 9)
+      handle_error("xz preset must be in the range [0, 9]: " + spec);
+  } else if (name == "zstd") {
+    if (parts.size() > 3)
+      handle_error("invalid codec: " + spec);
+    codec.type = CodecType::ZSTD;
+    codec.level = ZSTD_CLEVEL_DEFAULT;
+    codec.extreme = false;
+    if (parts.size() >= 2)
+      codec.level = parse_int(parts[1], spec);
+    if (codec.level < 1 || codec.level > ZSTD_maxCLevel())
+      handle_error(format("zstd level must be in the range [1, %d]: %s",
+                          (long long)ZSTD_maxCLevel(), spec.c_str()));
+    if (parts.size() == 3) {
+      auto &mode = parts[2];
+      if (mode == "long")
+        codec.window_log = ZSTD_DEFAULT_LONG_WINDOW_LOG;
+      else if (mode.compare(0, 5, "long=") == 0)
+        codec.window_log = parse_int(mode.substr(5), spec);
+      else
+        handle_error("invalid codec: " + spec);
+      auto bounds = ZSTD_cParam_getBounds(ZSTD_c_windowLog);
+      if (codec.window_log < bounds.lowerBound ||
+          codec.window_log > bounds.upperBound)
+        handle_error(
+            format("zstd long window must be in the range [%d, %d]: %s",
+                   (long long)bounds.lowerBound, (long long)bounds.upperBound,
+                   spec.c_str()));
+    }
+  } else {
+    handle_error("unknown codec: " + spec);
+  }
+  return codec;
+}
+
+std::string codec_name(const Codec &codec) {
+  switch (codec.type) {
+  case CodecType::STORE:
+    return "store";
+  case CodecType::XZ:
+    return "xz:" + std::to_string(codec.level) + (codec.extreme ? "e" : "");
+  case CodecType::ZSTD: {
+    auto name = "zstd:" + std::to_string(codec.level);
+    if (codec.window_log)
+      name += ":long=" + std::to_string(codec.window_log);
+    return name;
+  }
+  }
+  return "";
+}
+
+const char *codec_extension(const Codec &codec) {
+  switch (codec.type) {
+  case CodecType::STORE:
+    return ".tar";
+  case CodecType::XZ:
+    return ".tar.xz";
+  case CodecType::ZSTD:
+    return ".tar.zst";
+  }
+  return "";
+}
+
+// 使用 liblzma 在内存中压缩，preset 与 xz 命令行的 -0 ~ -9 相同
+static void xz_compress(const std::string &input, std::string &output,
+                        uint32_t preset, bool extreme) {
+  if (extreme)
+    preset |= LZMA_PRESET_EXTREME;
+  output.resize(lzma_stream_buffer_bound(input.size()));
+  size_t out_pos = 0;
+  auto ret = lzma_easy_buffer_encode(
+      preset, LZMA_CHECK_CRC64, nullptr,
+      reinterpret_cast<const uint8_t *>(input.data()), input.size(),
+      reinterpret_cast<uint8_t *>(output.data()), &out_pos, output.size());
+  if (ret != LZMA_OK)
+    handle_error(
+        format("xz compression failed, error code: %d", (long long)ret));
+  output.resize(out_pos);
+}
+
+static void xz_decompress(const char *data, size_t size, std::string &output) {
+  lzma_stream strm = LZMA_STREAM_INIT;
+  auto ret = lzma_stream_decoder(&strm, UINT64_MAX, LZMA_CONCATENATED);
+  if (ret != LZMA_OK)
+    handle_error(
+        format("xz decompression failed, error code: %d", (long long)ret));
+
+  output.resize(std::max<size_t>(size * 4, 4096));
+  strm.next_in = reinterpret_cast<const uint8_t *>(data);
+  strm.avail_in = size;
+  size_t out_pos = 0;
+  do {
+    if (out_pos == output.size())
+      output.resize(output.size() * 2);
+    strm.next_out = reinterpret_cast<uint8_t *>(output.data()) + out_pos;
+    strm.avail_out = output.size() - out_pos;
+    ret = lzma_code(&strm, LZMA_FINISH);
+    out_pos = output.size() - strm.avail_out;
+  } while (ret == LZMA_OK);
+  lzma_end(&strm);
+  if (ret != LZMA_STREAM_END)
+    handle_error(
+        format("xz decompression failed, error code: %d", (long long)ret));
+  output.resize(out_pos);
+}
+
+// 与 xz -N[e] 相同参数的 LZMA2 过滤器链
+struct Lzma2Filters {
+  lzma_options_lzma options;
+  lzma_filter filters[2];
+
+  Lzma2Filters(uint32_t preset, bool extreme) {
+    if (extreme)
+      preset |= LZMA_PRESET_EXTREME;
+    if (lzma_lzma_preset(&options, preset))
+      handle_error(format("invalid xz preset: %d", (long long)preset));
+    filters[0] = {LZMA_FILTER_LZMA2, &options};
+    filters[1] = {LZMA_VLI_UNKNOWN, nullptr};
+  }
+};
+
+static void xz_compress_raw(const char *data, size_t size, std::string &output,
+                            uint32_t preset, bool extreme) {
+  Lzma2Filters lzma2(preset, extreme);
+  output.resize(lzma_stream_buffer_bound(size));
+  size_t out_pos = 0;
+  auto ret = lzma_raw_buffer_encode(
+      lzma2.filters, nullptr, reinterpret_cast<const uint8_t *>(data), size,
+      reinterpret_cast<uint8_t *>(output.data()), &out_pos, output.size());
+  if (ret != LZMA_OK)
+    handle_error(
+        format("xz compression failed, error code: %d", (long long)ret));
+  output.resize(out_pos);
+}
+
+static void xz_decompress_raw(const char *data, size_t size, size_t raw_size,
+                              std::string &output, uint32_t preset,
+                              bool extreme) {
+  Lzma2Filters lzma2(preset, extreme);
+  output.resize(raw_size);
+  size_t in_pos = 0, out_pos = 0;
+  auto ret = lzma_raw_buffer_decode(
+      lzma2.filters, nullptr, reinterpret_cast<const uint8_t *>(data), &in_pos,
+      size, reinterpret_cast<uint8_t *>(output.data()), &out_pos,
+      output.size());
+  if (ret != LZMA_OK && ret != LZMA_STREAM_END)
+    handle_error(
+        format("xz decompression failed, error code: %d", (long long)ret));
+  if (out_pos != raw_size)
+    handle_error("xz decompression: stream size mismatch");
+}
+
+static void zstd_compress(const char *data, size_t size, std::string &output,
+                          int level, int window_log, bool checksum) {
+  // 每个归档线程复用一个压缩上下文，避免每块重新分配
+  struct CCtxDeleter {
+    void operator()(ZSTD_CCtx *cctx) const { ZSTD_freeCCtx(cctx); }
+  };
+  thread_local std::unique_ptr<ZSTD_CCtx, CCtxDeleter> cctx(ZSTD_createCCtx());
+  if (!cctx)
+    handle_error("zstd: failed to create compression context");
+
+  auto *ctx = cctx.get();
+  ZSTD_CCtx_reset(ctx, ZSTD_reset_session_and_parameters);
+  ZSTD_CCtx_setParameter(ctx, ZSTD_c_compressionLevel, level);
+  ZSTD_CCtx_setParameter(ctx, ZSTD_c_checksumFlag, checksum);
+  if (window_log) {
+    ZSTD_CCtx_setParameter(ctx, ZSTD_c_enableLongDistanceMatching, 1);
+    ZSTD_CCtx_setParameter(ctx, ZSTD_c_windowLog, window_log);
+  }
+
+  output.resize(ZSTD_compressBound(size));
+  size_t out_size =
+      ZSTD_compress2(ctx, output.data(), output.size(), data, size);
+  if (ZSTD_isError(out_size))
+    handle_error(std::string("zstd compression failed: ") +
+                 ZSTD_getErrorName(out_size));
+  output.resize(out_size);
+}
+
+static void zstd_decompress(const char *data, size_t size, size_t raw_size,
+                            std::string &output) {
+  struct DCtxDeleter {
+    void operator()(ZSTD_DCtx *dctx) const { ZSTD_freeDCtx(dctx); }
+  };
+  thread_local std::unique_ptr<ZSTD_DCtx, DCtxDeleter> dctx(ZSTD_createDCtx());
+  if (!dctx)
+    handle_error("zstd: failed to create decompression context");
+
+  auto *ctx = dctx.get();
+  ZSTD_DCtx_reset(ctx, ZSTD_reset_session_and_parameters);
+  // 允许 --long 写出的大窗口
+  ZSTD_DCtx_setParameter(ctx, ZSTD_d_windowLogMax,
+                         ZSTD_dParam_getBounds(ZSTD_d_windowLogMax).upperBound);
+  output.resize(raw_size);
+  size_t out_size =
+      ZSTD_decompressDCtx(ctx, output.data(), output.size(), data, size);
+  if (ZSTD_isError(out_size))
+    handle_error(std::string("zstd decompression failed: ") +
+                 ZSTD_getErrorName(out_size));
+  if (out_size != raw_size)
+    handle_error("zstd decompression: stream size mismatch");
+}
+
+static void zstd_decompress_frames(const char *data, size_t size,
+                                   std::string &output) {
+  std::unique_ptr<ZSTD_DStream, size_t (*)(ZSTD_DStream *)> dstream(
+      ZSTD_createDStream(), ZSTD_freeDStream);
+  if (!dstream)
+    handle_error("zstd: failed to create decompression context");
+  ZSTD_DCtx_setParameter(dstream.get(), ZSTD_d_windowLogMax,
+                         ZSTD_dParam_getBounds(ZSTD_d_windowLogMax).upperBound);
+
+  auto content_size = ZSTD_getFrameContentSize(data, size);
+  output.resize(content_size != ZSTD_CONTENTSIZE_UNKNOWN &&
+                        content_size != ZSTD_CONTENTSIZE_ERROR
+                    ? content_size
+                    : std::max<size_t>(size * 4, 4096));
+  ZSTD_inBuffer in{data, size, 0};
+  ZSTD_outBuffer out{output.data(), output.size(), 0};
+  while (in.pos < in.size) {
+    if (out.pos == out.size) {
+      output.resize(output.size() * 2);
+      out.dst = output.data();
+      out.size = output.size();
+    }
+    size_t ret = ZSTD_decompressStream(dstream.get(), &out, &in);
+    if (ZSTD_isError(ret))
+      handle_error(std::string("zstd decompression failed: ") +
+                   ZSTD_getErrorName(ret));
+  }
+  output.resize(out.pos);
+}
+
+void codec_decompress(const char *data, size_t size, std::string &output) {
+  static const char XZ_MAGIC[] = {'\xFD', '7', 'z', 'X', 'Z', '\0'};
+  static const char ZSTD_MAGIC[] = {'\x28', '\xB5', '\x2F', '\xFD'};
+  auto has_magic = [&](const char *magic, size_t len) {
+    return size >= len && std::memcmp(data, magic, len) == 0;
+  };
+  if (has_magic(XZ_MAGIC, sizeof(XZ_MAGIC)))
+    xz_decompress(data, size, output);
+  else if (has_magic(ZSTD_MAGIC, sizeof(ZSTD_MAGIC)))
+    zstd_decompress_frames(data, size, output);
+  else
+    output.assign(data, size);
+}
+
+void codec_compress(const Codec &codec, const std::string &input,
+                    std::string &output) {
+  switch (codec.type) {
+  case CodecType::STORE:
+    output = input;
+    break;
+  case CodecType::XZ:
+    xz_compress(input, output, codec.level, codec.extreme);
+    break;
+  case CodecType::ZSTD:
+    zstd_compress(input.data(), input.size(), output, codec.level,
+                  codec.window_log, true);
+    break;
+  }
+}
+
+void codec_compress_block(const Codec &codec, const char *data, size_t size,
+                          std::string &output) {
+  switch (codec.type) {
+  case CodecType::STORE:
+    output.assign(data, size);
+    break;
+  case CodecType::XZ:
+    xz_compress_raw(data, size, output, codec.level, codec.extreme);
+    break;
+  case CodecType::ZSTD:
+    zstd_compress(data, size, output, codec.level, codec.window_log, false);
+    break;
+  }
+}
+
+void codec_decompress_block(const Codec &codec, const char *data, size_t size,
+                            size_t raw_size, std::string &output) {
+  switch (codec.type) {
+  case CodecType::STORE:
+    if (size != raw_size)
+      handle_error("stored stream size mismatch");
+    output.assign(data, size);
+    break;
+  case CodecType::XZ:
+    xz_decompress_raw(data, size, raw_size, output, codec.level,
+                      codec.extreme);
+    break;
+  case CodecType::ZSTD:
+    zstd_decompress(data, size, raw_size, output);
+    break;
+  }
+}
@@ -0,0 +1,274 @@
+#include <Container.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <lzma.h>
+#include <string>
+#include <utility>
+#include <utils/util.hpp>
+#include <vector>
+
+static constexpr char CONTAINER_MAGIC[4] = {'L', 'G', 'F', 'A'};
+// 版本 2 在目录末尾追加共享区，版本 3 为每个流记录 CRC32。
+// 写出时总是使用版本 3，读取时兼容之前的版本
+static constexpr uint8_t CONTAINER_SHARED_VERSION = 2;
+static constexpr uint8_t CONTAINER_CRC_VERSION = 3;
+static constexpr size_t HEADER_SIZE = sizeof(CONTAINER_MAGIC) + 1;
+static constexpr size_t TRAILER_SIZE = 8 + 8 + sizeof(CONTAINER_MAGIC);
+
+static void put_varint(std::string &out, uint64_t value) {
+  do {
+    uint8_t byte = value & 0x7F;
+    value >>= 7;
+    if (value != 0)
+      byte |= 0x80;
+    out.push_back(byte);
+  } while (value != 0);
+}
+
+static void put_u64(std::string &out, uint64_t value) {
+  for (int i = 0; i < 8; ++i)
+    out.push_back(char((value >> (8 * i)) & 0xFF));
+}
+
+static uint64_t get_u64(const char *data) {
+  uint64_t value = 0;
+  for (int i = 7; i >= 0; --i)
+    value = (value << 8) | uint8_t(data[i]);
+  return value;
+}
+
+// 顺序解析目录，越界即视为文件损坏
+class IndexCursor {
+private:
+  const char *cur, *end;
+
+public:
+  IndexCursor(const char *data, size_t size) : cur(data), end(data + size) {}
+
+  uint64_t varint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (cur >= end)
+        break;
+      uint8_t byte = *cur++;
+      value |= uint64_t(byte & 0x7F) << shift;
+      if (!(byte & 0x80))
+        return value;
+    }
+    handle_error("Corrupted container index");
+    return 0;
+  }
+
+  std::string bytes(size_t size) {
+    if (size_t(end - cur) < size)
+      handle_error("Corrupted container index");
+    std::string value(cur, size);
+    cur += size;
+    return value;
+  }
+
+  // 读取之后的表项个数。每项至少占 min_bytes 字节，
+  // 超过剩余目录所能容纳的个数即为损坏，不按其分配内存
+  size_t count(size_t min_bytes) {
+    uint64_t value = varint();
+    if (value > uint64_t(end - cur) / min_bytes)
+      handle_error("Corrupted container index");
+    return size_t(value);
+  }
+};
+
+static uint32_t stream_crc32(const char *data, size_t size) {
+  return lzma_crc32(reinterpret_cast<const uint8_t *>(data), size, 0);
+}
+
+ContainerWriter::ContainerWriter(std::string path, const Codec &codec)
+    : path(std::move(path)), codec(codec) {
+  writer.open(this->path, std::ios::binary);
+  if (!writer.is_open())
+    handle_error(
+        format("Failed to create output file: %s", this->path.c_str()));
+  writer.write(CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC));
+  writer.put(char(CONTAINER_CRC_VERSION));
+  pos = HEADER_SIZE;
+}
+
+// 压缩各个流后追加到文件末尾，返回的 entry 只填写了字节范围与流
+ChunkEntry ContainerWriter::write_entry(ChunkArchive &archive) {
+  ChunkEntry entry{0, 0, 0, 0, 0, {}};
+  std::string blob, compressed;
+  for (auto &[name, data] : archive.entries()) {
+    codec_compress_block(codec, data.data(), data.size(), compressed);
+    entry.streams.push_back({name, uint64_t(blob.size()), compressed.size(),
+                             data.size(),
+                             stream_crc32(data.data(), data.size())});
+    blob += compressed;
+  }
+  entry.size = blob.size();
+
+  std::lock_guard<std::mutex> lock(mtx);
+  entry.offset = pos;
+  writer.write(blob.data(), blob.size());
+  if (!writer)
+    handle_error(format("Failed to write output file: %s", path.c_str()));
+  pos += blob.size();
+  return entry;
+}
+
+void ContainerWriter::append(uint64_t chunk_idx, uint64_t first_line,
+                             uint64_t line_count, ChunkArchive &archive) {
+  auto entry = write_entry(archive);
+  entry.chunk_idx = chunk_idx;
+  entry.first_line = first_line;
+  entry.line_count = line_count;
+  std::lock_guard<std::mutex> lock(mtx);
+  chunks.push_back(std::move(entry));
+}
+
+void ContainerWriter::set_shared(ChunkArchive &archive) {
+  auto entry = write_entry(archive);
+  std::lock_guard<std::mutex> lock(mtx);
+  shared = std::move(entry);
+}
+
+static void put_streams(std::string &index, const ChunkEntry &entry) {
+  put_varint(index, entry.streams.size());
+  for (auto &stream : entry.streams) {
+    put_varint(index, stream.name.size());
+    index += stream.name;
+    put_varint(index, stream.offset);
+    put_varint(index, stream.size);
+    put_varint(index, stream.raw_size);
+    put_varint(index, stream.crc32);
+  }
+}
+
+void ContainerWriter::finish() {
+  std::lock_guard<std::mutex> lock(mtx);
+  std::sort(chunks.begin(), chunks.end(),
+            [](const ChunkEntry &a, const ChunkEntry &b) {
+              return a.chunk_idx < b.chunk_idx;
+            });
+
+  std::string index;
+  put_varint(index, uint64_t(codec.type));
+  put_varint(index, codec.level);
+  put_varint(index, codec.extreme);
+  put_varint(index, codec.window_log);
+  put_varint(index, chunks.size());
+  for (auto &chunk : chunks) {
+    put_varint(index, chunk.chunk_idx);
+    put_varint(index, chunk.first_line);
+    put_varint(index, chunk.line_count);
+    put_varint(index, chunk.offset);
+    put_varint(index, chunk.size);
+    put_streams(index, chunk);
+  }
+  // 没有共享区时写出位于目录之前的空范围
+  if (shared.streams.empty())
+    shared.offset = pos;
+  put_varint(index, shared.offset);
+  put_varint(index, shared.size);
+  put_streams(index, shared);
+  put_u64(index, pos);
+  put_u64(index, index.size() - 8);
+  index.append(CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC));
+
+  writer.write(index.data(), index.size());
+  writer.close();
+  if (!writer)
+    handle_error(format("Failed to write output file: %s", path.c_str()));
+}
+
+ContainerReader::ContainerReader(const std::string &path) : file(path) {
+  auto *data = file.data();
+  size_t size = file.size();
+  if (size < HEADER_SIZE + TRAILER_SIZE ||
+      std::memcmp(data, CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC)) != 0 ||
+      std::memcmp(data + size - sizeof(CONTAINER_MAGIC), CONTAINER_MAGIC,
+                  sizeof(CONTAINER_MAGIC)) != 0)
+    handle_error("Not a LogFold container: " + path);
+  uint8_t version = uint8_t(data[sizeof(CONTAINER_MAGIC)]);
+  if (version < 1 || version > CONTAINER_CRC_VERSION)
+    handle_error("Unsupported container version: " + path);
+  has_crc = version >= CONTAINER_CRC_VERSION;
+
+  auto *trailer = data + size - TRAILER_SIZE;
+  uint64_t index_offset = get_u64(trailer), index_size = get_u64(trailer + 8);
+  if (index_offset < HEADER_SIZE || index_offset > size - TRAILER_SIZE ||
+      index_size != size - TRAILER_SIZE - index_offset)
+    handle_error("Corrupted container index: " + path);
+
+  IndexCursor index(data + index_offset, index_size);
+  uint64_t codec_type = index.varint();
+  if (codec_type > uint64_t(CodecType::ZSTD))
+    handle_error("Unknown codec in container index: " + path);
+  _codec.type = CodecType(codec_type);
+  _codec.level = int(index.varint());
+  _codec.extreme = index.varint() != 0;
+  _codec.window_log = int(index.varint());
+  // 流的偏移相对于所在块（或共享区）的起点
+  auto read_streams = [&](ChunkEntry &entry) {
+    if (entry.offset < HEADER_SIZE || entry.offset > index_offset ||
+        entry.size > index_offset - entry.offset)
+      handle_error("Corrupted container index: " + path);
+    // 每个流至少有名字长度、偏移、长度与原始长度（及 CRC32）各一个字节
+    entry.streams.resize(index.count(has_crc ? 5 : 4));
+    for (auto &stream : entry.streams) {
+      stream.name = index.bytes(index.varint());
+      stream.offset = index.varint();
+      stream.size = index.varint();
+      stream.raw_size = index.varint();
+      uint64_t crc = has_crc ? index.varint() : 0;
+      if (crc > UINT32_MAX)
+        handle_error("Corrupted container index: " + path);
+      stream.crc32 = uint32_t(crc);
+      if (stream.offset > entry.size ||
+          stream.size > entry.size - stream.offset)
+        handle_error("Corrupted container index: " + path);
+    }
+  };
+  // 每个块至少有 5 个整数与流的个数各一个字节
+  _chunks.resize(index.count(6));
+  for (auto &chunk : _chunks) {
+    chunk.chunk_idx = index.varint();
+    chunk.first_line = index.varint();
+    chunk.line_count = index.varint();
+    chunk.offset = index.varint();
+    chunk.size = index.varint();
+    read_streams(chunk);
+  }
+  if (version >= CONTAINER_SHARED_VERSION) {
+    _shared.offset = index.varint();
+    _shared.size = index.varint();
+    read_streams(_shared);
+  }
+}
+
+const StreamEntry *ContainerReader::find_stream(const ChunkEntry &chunk,
+                                                const std::string &name) {
+  for (auto &stream : chunk.streams) {
+    if (stream.name == name)
+      return &stream;
+  }
+  return nullptr;
+}
+
+std::string ContainerReader::read_stream(const ChunkEntry &chunk,
+                                         const StreamEntry &stream) const {
+  std::string output;
+  codec_decompress_block(_codec, file.data() + chunk.offset + stream.offset,
+                         stream.size, stream.raw_size, output);
+  if (has_crc && stream_crc32(output.data(), output.size()) != stream.crc32)
+    handle_error(format("Checksum mismatch in container stream %s of chunk %d",
+                        stream.name.c_str(), (long long)chunk.chunk_idx));
+  return output;
+}
+
+ChunkArchive ContainerReader::read_chunk(const ChunkEntry &chunk) const {
+  ChunkArchive archive;
+  for (auto &stream : chunk.streams)
+    archive.file(stream.name) = read_stream(chunk, stream);
+  return archive;
+}
@@ -0,0 +1,477 @@
+#include <ColumnCodec.hpp>
+#include <LogDecoder.hpp>
+#include <TokenManager.hpp>
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <utils/Timestamp.hpp>
+#include <utils/util.hpp>
+#include <vector>
+
+// number2letter 的逆过程：a -> 0, z -> 25, aa -> 26 ...
+static uint64_t letter2number(std::string_view letters) {
+  if (letters.size() == 1)
+    return letters[0] - 'a';
+  uint64_t num = 0, base = 0, power = 1;
+  for (size_t i = letters.size(); i-- > 0;) {
+    num += (letters[i] - 'a') * power;
+    power *= 26;
+    base += power;
+  }
+  // base = 26 + 26^2 + ... + 26^(n-1)
+  return base - power + num;
+}
+
+static void append_uint(std::string &out, uint64_t value) {
+  char buf[20];
+  auto res = std::to_chars(buf, buf + sizeof(buf), value);
+  out.append(buf, res.ptr - buf);
+}
+
+static void append_int(std::string &out, int64_t value) {
+  char buf[21];
+  auto res = std::to_chars(buf, buf + sizeof(buf), value);
+  out.append(buf, res.ptr - buf);
+}
+
+// 按换行符切分，末尾的换行符不产生空行
+static void split_lines(std::string_view data,
+                        std::vector<std::string_view> &lines) {
+  size_t start = 0;
+  while (start < data.size()) {
+    size_t end = data.find('\n', start);
+    if (end == std::string_view::npos)
+      end = data.size();
+    lines.push_back(data.substr(start, end - start));
+    start = end + 1;
+  }
+}
+
+static bool is_digits(std::string_view text) {
+  return !text.empty() && std::all_of(text.begin(), text.end(), [](char c) {
+    return c >= '0' && c <= '9';
+  });
+}
+
+ChunkDecoder::ChunkDecoder(ChunkStreams streams) : streams(std::move(streams)) {
+  timestamps.resize(timestamp_format_count());
+  // 块内没有需要登记的子 token 时不会写出 token.txt
+  token_data = read_stream(TOKEN_DICT_STREAM, false);
+  split_lines(token_data, tokens);
+
+  // 编译模板时需要字典大小来判断 |word| 是否为 dict id
+  template_data = read_stream(TEMPLATE_DICT_STREAM, true);
+  std::vector<std::string_view> template_lines;
+  split_lines(this->streams.shared_templates, template_lines);
+  split_lines(template_data, template_lines);
+  templates.resize(template_lines.size());
+  for (size_t i = 0; i < template_lines.size(); ++i)
+    compile_template(template_lines[i], templates[i]);
+
+  // Stream VByte 流至少含值的个数，为空即不存在
+  auto template_id_data = read_stream(TEMPLATE_ID_SVB_STREAM, false);
+  if (!template_id_data.empty()) {
+    SubTokenCompressor::read_stream_vbyte(template_id_data, template_ids);
+  } else {
+    template_id_data = read_stream(TEMPLATE_ID_STREAM, true);
+    const char *cur = template_id_data.data(),
+               *end = cur + template_id_data.size();
+    while (cur < end)
+      template_ids.push_back(
+          uint32_t(SubTokenCompressor::read_unsigned_leb128(cur, end)));
+  }
+
+  token_id_stream = TOKEN_ID_SVB_STREAM;
+  auto token_id_data = read_stream(token_id_stream, false);
+  if (!token_id_data.empty()) {
+    SubTokenCompressor::read_stream_vbyte(token_id_data, token_ids);
+  } else {
+    token_id_stream = TOKEN_ID_STREAM;
+    token_id_data = read_stream(token_id_stream, false);
+    const char *cur = token_id_data.data(), *end = cur + token_id_data.size();
+    while (cur < end) {
+      uint64_t id = SubTokenCompressor::read_unsigned_leb128(cur, end);
+      if (id > UINT32_MAX)
+        handle_error("Token id out of range: " + std::to_string(id));
+      token_ids.push_back(uint32_t(id));
+    }
+  }
+
+  for (auto &name : this->streams.names) {
+    uint64_t dict_id;
+    MatrixStream matrix;
+    if (!SubTokenCompressor::parse_matrix_name(name, dict_id, matrix.is_delta,
+                                               matrix.lengths, matrix.types))
+      continue;
+    matrix.name = name;
+    matrices.emplace_back(dict_id, std::move(matrix));
+  }
+  std::sort(matrices.begin(), matrices.end(),
+            [](const auto &a, const auto &b) { return a.first < b.first; });
+}
+
+void ChunkDecoder::corrupt(const std::string &problem,
+                           const std::string &detail) const {
+  handle_error(problem + " in " + streams.source + ": " + detail);
+}
+
+std::string ChunkDecoder::read_stream(const std::string &name, bool required) {
+  std::string data;
+  if (!streams.read(name, data) && required)
+    corrupt("Missing stream", name);
+  return data;
+}
+
+void ChunkDecoder::compile_template(std::string_view templ,
+                                    std::vector<Op> &ops) {
+  size_t literal_start = 0, i = 0;
+  auto flush_literal = [&](size_t end) {
+    if (end > literal_start)
+      ops.push_back({OpType::LITERAL, 0,
+                     templ.substr(literal_start, end - literal_start)});
+  };
+
+  while (i < templ.size()) {
+    char c = templ[i];
+    if (c == '<' && i + 2 < templ.size() && templ[i + 2] == '>') {
+      char key = templ[i + 1];
+      if (key == '*' || (key >= 'a' && key <= 'o')) {
+        flush_literal(i);
+        if (key == '*')
+          ops.push_back({OpType::TOKEN_ID, 0, {}});
+        else
+          ops.push_back({OpType::NUMBER, uint64_t(key - 'a' + 1), {}});
+        i += 3;
+        literal_start = i;
+        continue;
+      }
+    } else if (c == '<' && i + 1 < templ.size() && templ[i + 1] == 't') {
+      // <t格式编号>，未知的格式编号按原文处理
+      size_t end = i + 2;
+      uint64_t format = 0;
+      while (end < templ.size() && end < i + 5 && templ[end] >= '0' &&
+             templ[end] <= '9')
+        format = format * 10 + (templ[end++] - '0');
+      if (end > i + 2 && end < templ.size() && templ[end] == '>' &&
+          format < timestamps.size()) {
+        flush_literal(i);
+        ops.push_back({OpType::TIMESTAMP, format, {}});
+        i = end + 1;
+        literal_start = i;
+        continue;
+      }
+    } else if (c == '|') {
+      // |字母| 为 dict id 标记。编码时不会把形如 |word| 或 <a> 的原文留在
+      // 模板中；id 超出字典范围时按原文处理，兼容之前写出的归档
+      size_t end = i + 1;
+      while (end < templ.size() && templ[end] >= 'a' && templ[end] <= 'z')
+        ++end;
+      size_t len = end - i - 1;
+      if (len > 0 && len <= 12 && end < templ.size() && templ[end] == '|') {
+        uint64_t dict_id = letter2number(templ.substr(i + 1, len));
+        if (dict_id < tokens.size()) {
+          flush_literal(i);
+          ops.push_back({OpType::DICT, dict_id, {}});
+          i = end + 1;
+          literal_start = i;
+          continue;
+        }
+      }
+    }
+    ++i;
+  }
+  flush_literal(templ.size());
+}
+
+void ChunkDecoder::load_numbers(size_t length) {
+  auto &stream = numbers[length];
+  stream.loaded = true;
+  std::string data,
+      name = SubTokenCompressor::base_binary_name(uint32_t(length), 0);
+  stream.exists = streams.read(name, data);
+  if (!stream.exists || data.empty())
+    return;
+  read_column(data.data(), data.data() + data.size(), 0, true, stream.values,
+              name);
+}
+
+void ChunkDecoder::append_number(std::string &out, size_t length) {
+  auto &stream = numbers[length];
+  if (!stream.loaded)
+    load_numbers(length);
+  if (stream.cursor >= stream.values.size()) {
+    auto name = SubTokenCompressor::base_binary_name(uint32_t(length), 0);
+    corrupt(stream.exists ? "Too few values in stream" : "Missing stream",
+            name);
+    return;
+  }
+
+  // 按固定长度补前导零
+  char buf[20];
+  auto res = std::to_chars(buf, buf + sizeof(buf),
+                           int64_t(stream.values[stream.cursor++]));
+  size_t digits = res.ptr - buf;
+  if (digits < length)
+    out.append(length - digits, '0');
+  out.append(buf, std::min(digits, length));
+}
+
+void ChunkDecoder::load_timestamps(size_t format) {
+  auto &stream = timestamps[format];
+  stream.loaded = true;
+  std::string data,
+      name = SubTokenCompressor::timestamp_name(uint32_t(format));
+  stream.exists = streams.read(name, data);
+  if (!stream.exists || data.empty())
+    return;
+  read_column(data.data(), data.data() + data.size(), 0, true, stream.values,
+              name);
+}
+
+void ChunkDecoder::append_timestamp(std::string &out, size_t format) {
+  auto &stream = timestamps[format];
+  if (!stream.loaded)
+    load_timestamps(format);
+  if (stream.cursor >= stream.values.size()) {
+    auto name = SubTokenCompressor::timestamp_name(uint32_t(format));
+    corrupt(stream.exists ? "Too few values in stream" : "Missing stream",
+            name);
+    return;
+  }
+  ::append_timestamp(out, format, int64_t(stream.values[stream.cursor++]));
+}
+
+void ChunkDecoder::load_matrix(MatrixStream &matrix) {
+  matrix.loaded = true;
+  std::string data;
+  if (!streams.read(matrix.name, data) || data.empty())
+    return;
+
+  const char *cur = data.data(), *end = cur + data.size();
+  matrix.positions = SubTokenCompressor::read_unsigned_leb128(cur, end);
+  matrix.instances = SubTokenCompressor::read_unsigned_leb128(cur, end);
+  // delta 优化的矩阵只有一列拼接后的数字
+  if (matrix.is_delta && matrix.positions != 1) {
+    matrix.positions = matrix.instances = 0;
+    return;
+  }
+  matrix.values.reserve(matrix.positions * matrix.instances);
+
+  for (size_t p = 0; p < matrix.positions; ++p) {
+    if (matrix.is_delta) {
+      // 首个值为基准，之后为 (|delta| << 1) | 符号位
+      int64_t prev = 0;
+      for (size_t i = 0; i < matrix.instances; ++i) {
+        uint64_t encoded = SubTokenCompressor::read_unsigned_leb128(cur, end);
+        if (i == 0)
+          prev = int64_t(encoded);
+        else if (encoded & 1)
+          prev -= int64_t(encoded >> 1);
+        else
+          prev += int64_t(encoded >> 1);
+        matrix.values.push_back(uint64_t(prev));
+      }
+      continue;
+    }
+
+    cur = read_column(cur, end, matrix.instances, false, matrix.values,
+                      matrix.name);
+  }
+}
+
+void ChunkDecoder::append_instance(std::string &out, MatrixStream &matrix) {
+  size_t instance = matrix.cursor++;
+  auto &parts = matrix.pattern_parts;
+  // 与 Python 脚本相同：值比占位符多时直接追加，少时丢弃剩余部分
+  size_t value_idx = 0;
+  auto emit = [&](std::string_view value) {
+    out += value;
+    if (value_idx + 1 < parts.size())
+      out += parts[value_idx + 1];
+    ++value_idx;
+  };
+  out += parts[0];
+
+  std::string value;
+  if (matrix.is_delta) {
+    size_t total = 0;
+    for (auto len : matrix.lengths)
+      total += len > 0 ? len : 0;
+    append_int(value, int64_t(matrix.values[instance]));
+    if (value.size() < total)
+      value.insert(0, total - value.size(), '0');
+    else if (value.size() > total)
+      value.erase(0, value.size() - total);
+
+    size_t start = 0;
+    for (auto len : matrix.lengths) {
+      if (len <= 0) {
+        emit({});
+        continue;
+      }
+      emit(std::string_view(value).substr(start, len));
+      start += len;
+    }
+    return;
+  }
+
+  // c 为模式中的列，p 为存放的位置
+  for (size_t c = 0, p = 0; p < matrix.positions; ++c) {
+    auto type =
+        c < matrix.types.size() ? matrix.types[c] : SubTokenType::TAGGED;
+    value.clear();
+    if (type != SubTokenType::TAGGED) {
+      size_t width = size_t(matrix.lengths[c]);
+      size_t slots = sub_token_slots(type, width);
+      uint64_t parts[2] = {};
+      for (size_t s = 0; s < slots && p < matrix.positions; ++s, ++p)
+        parts[s] = matrix.values[p * matrix.instances + instance];
+      append_sub_token(value, type, width, parts);
+      emit(value);
+      continue;
+    }
+
+    uint64_t v = matrix.values[p++ * matrix.instances + instance];
+    if (v % 2 == 0) {
+      append_uint(value, v / 2);
+    } else if ((v - 1) / 2 < tokens.size()) {
+      value = tokens[(v - 1) / 2];
+    } else {
+      corrupt("Unknown sub-token id " + std::to_string((v - 1) / 2) +
+                  " in stream",
+              matrix.name);
+      return;
+    }
+    if (c < matrix.lengths.size() && matrix.lengths[c] > 0) {
+      size_t len = matrix.lengths[c];
+      if (value.size() < len && is_digits(value))
+        value.insert(0, len - value.size(), '0');
+      else if (value.size() > len)
+        value.resize(len);
+    }
+    emit(value);
+  }
+}
+
+bool ChunkDecoder::is_composite(uint64_t dict_id) const {
+  return dict_id < tokens.size() &&
+         tokens[dict_id].find("<>") != std::string_view::npos;
+}
+
+ChunkDecoder::MatrixStream *ChunkDecoder::find_matrix(uint64_t dict_id) {
+  auto it = std::lower_bound(
+      matrices.begin(), matrices.end(), dict_id,
+      [](const auto &entry, uint64_t id) { return entry.first < id; });
+  if (it == matrices.end() || it->first != dict_id)
+    return nullptr;
+  return &it->second;
+}
+
+void ChunkDecoder::append_dict(std::string &out, uint64_t dict_id) {
+  if (!is_composite(dict_id)) {
+    if (dict_id < tokens.size())
+      out += tokens[dict_id];
+    else
+      corrupt("Unknown token id " + std::to_string(dict_id) + " from stream",
+              token_id_stream);
+    return;
+  }
+
+  auto *matrix = find_matrix(dict_id);
+  if (matrix && !matrix->loaded) {
+    load_matrix(*matrix);
+    std::string_view pattern = tokens[dict_id];
+    size_t start = 0, pos;
+    while ((pos = pattern.find("<>", start)) != std::string_view::npos) {
+      matrix->pattern_parts.push_back(pattern.substr(start, pos - start));
+      start = pos + 2;
+    }
+    matrix->pattern_parts.push_back(pattern.substr(start));
+  }
+
+  if (!matrix)
+    corrupt("Missing variable matrix stream for dict id",
+            std::to_string(dict_id));
+  else if (matrix->instances == 0)
+    corrupt("Invalid variable matrix stream", matrix->name);
+  else if (matrix->cursor >= matrix->instances)
+    corrupt("Too few instances in stream", matrix->name);
+  else
+    append_instance(out, *matrix);
+}
+
+// 只推进各个流的游标，不加载数字流与矩阵，
+// 因此跳过的行引用的列不会被解压
+void ChunkDecoder::skip_dict(uint64_t dict_id) {
+  if (!is_composite(dict_id))
+    return;
+  if (auto *matrix = find_matrix(dict_id))
+    ++matrix->cursor;
+}
+
+void ChunkDecoder::skip_line(const std::vector<Op> &ops) {
+  for (auto &op : ops) {
+    switch (op.type) {
+    case OpType::LITERAL:
+      break;
+    case OpType::TOKEN_ID:
+      if (token_id_pos < token_ids.size())
+        skip_dict(token_ids[token_id_pos++]);
+      break;
+    case OpType::NUMBER:
+      ++numbers[op.arg].cursor;
+      break;
+    case OpType::TIMESTAMP:
+      ++timestamps[op.arg].cursor;
+      break;
+    case OpType::DICT:
+      skip_dict(op.arg);
+      break;
+    }
+  }
+}
+
+void ChunkDecoder::decode(std::string &out, size_t first, size_t count) {
+  first = std::min(first, line_count());
+  size_t last = first + std::min(count, line_count() - first);
+  for (size_t i = 0; i < first; ++i) {
+    if (template_ids[i] < templates.size())
+      skip_line(templates[template_ids[i]]);
+  }
+
+  out.reserve(out.size() + (last - first) * 128);
+  for (size_t i = first; i < last; ++i) {
+    auto template_id = template_ids[i];
+    if (template_id >= templates.size()) {
+      corrupt("Template id out of range", std::to_string(template_id));
+      return;
+    }
+    for (auto &op : templates[template_id]) {
+      switch (op.type) {
+      case OpType::LITERAL:
+        out += op.text;
+        break;
+      case OpType::TOKEN_ID:
+        if (token_id_pos < token_ids.size())
+          append_dict(out, token_ids[token_id_pos++]);
+        else
+          corrupt("Too few values in stream", token_id_stream);
+        break;
+      case OpType::NUMBER:
+        append_number(out, op.arg);
+        break;
+      case OpType::TIMESTAMP:
+        append_timestamp(out, op.arg);
+        break;
+      case OpType::DICT:
+        append_dict(out, op.arg);
+        break;
+      }
+    }
+    out += '\n';
+  }
+}
@@ -0,0 +1,333 @@
+#include "ChunkArchive.hpp"
+#include "Codec.hpp"
+#include "Container.hpp"
+#include "SharedTemplates.hpp"
+#include "utils/BoundedQueue.hpp"
+#include "utils/MappedFile.hpp"
+#include "utils/StagePool.hpp"
+#include "utils/util.hpp"
+#include <LogDecoder.hpp>
+#include <algorithm>
+#include <arg.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+namespace chr = std::chrono;
+using namespace std;
+
+// 在解压流水线中传递的块
+struct DecodeTask {
+  size_t seq = 0; // 块在输入中的序号，也是输出顺序
+  string output;
+  size_t line_count = 0;
+};
+
+// <idx>.tar / <idx>.tar.xz / <idx>.tar.zst，返回是否匹配
+static bool parse_archive_name(const string &name, uint64_t &chunk_idx) {
+  size_t digits = 0;
+  while (digits < name.size() && isdigit((unsigned char)name[digits]))
+    ++digits;
+  if (digits == 0)
+    return false;
+  auto ext = name.substr(digits);
+  if (ext != ".tar" && ext != ".tar.xz" && ext != ".tar.zst")
+    return false;
+  chunk_idx = stoull(name.substr(0, digits));
+  return true;
+}
+
+// 输入目录下的全部块归档，按块号排序
+static vector<string> list_archives(const string &dir) {
+  vector<pair<uint64_t, string>> archives;
+  for (auto &entry : fs::directory_iterator(dir)) {
+    uint64_t chunk_idx;
+    if (entry.is_regular_file() &&
+        parse_archive_name(entry.path().filename().string(), chunk_idx))
+      archives.emplace_back(chunk_idx, entry.path().string());
+  }
+  sort(archives.begin(), archives.end());
+  vector<string> paths;
+  for (auto &[chunk_idx, path] : archives)
+    paths.push_back(move(path));
+  return paths;
+}
+
+// 解压的输入：容器，或按块号排序的一组 tar 归档
+struct LogInput {
+  unique_ptr<ContainerReader> container;
+  vector<string> archives;
+  string shared_templates; // 未使用共享模板字典时为空
+
+  size_t chunk_count() const {
+    return container ? container->chunks().size() : archives.size();
+  }
+  ChunkStreams streams(size_t i) const;
+};
+
+// 输入可以是容器文件、单个 tar 归档，或压缩时的输出目录
+static LogInput open_input(const string &path) {
+  LogInput input;
+  string file = path;
+  if (fs::is_directory(path)) {
+    auto container_path = path + "/" + CONTAINER_FILE_NAME;
+    if (fs::exists(container_path))
+      file = container_path;
+    else
+      input.archives = list_archives(path);
+  }
+  if (input.archives.empty()) {
+    if (!fs::is_regular_file(file))
+      handle_error("No compressed chunks found in: " + path);
+    MappedFile probe(file);
+    if (probe.size() >= 4 && string(probe.data(), 4) == "LGFA")
+      input.container = make_unique<ContainerReader>(file);
+    else
+      input.archives.push_back(file);
+  }
+
+  if (input.container) {
+    auto &shared = input.container->shared();
+    if (auto *stream =
+            ContainerReader::find_stream(shared, SHARED_TEMPLATE_STREAM))
+      input.shared_templates = input.container->read_stream(shared, *stream);
+  } else {
+    // 共享字典与块归档位于同一目录
+    auto dir = fs::is_directory(path) ? fs::path(path)
+                                      : fs::path(file).parent_path();
+    if (dir.empty())
+      dir = ".";
+    for (auto *ext : {".tar", ".tar.xz", ".tar.zst"}) {
+      auto shared_path = dir / (string(SHARED_ARCHIVE_NAME) + ext);
+      if (!fs::is_regular_file(shared_path))
+        continue;
+      string tar;
+      {
+        MappedFile shared_file(shared_path.string());
+        codec_decompress(shared_file.data(), shared_file.size(), tar);
+      }
+      auto archive = ChunkArchive::from_tar(tar);
+      for (auto &[name, data] : archive.entries()) {
+        if (name == SHARED_TEMPLATE_STREAM)
+          input.shared_templates = move(data);
+      }
+      break;
+    }
+  }
+  return input;
+}
+
+string read_shared_templates(const string &path) {
+  auto input = open_input(path);
+  if (input.shared_templates.empty())
+    handle_error("No shared templates found in: " + path);
+  return move(input.shared_templates);
+}
+
+ChunkStreams LogInput::streams(size_t i) const {
+  ChunkStreams streams;
+  streams.shared_templates = shared_templates;
+  if (container) {
+    // 容器中的流按需单独解压
+    auto *chunk = &container->chunks()[i];
+    streams.source = "chunk " + to_string(chunk->chunk_idx);
+    for (auto &stream : chunk->streams)
+      streams.names.push_back(stream.name);
+    streams.read = [reader = container.get(), chunk](const string &name,
+                                                    string &data) {
+      auto *stream = ContainerReader::find_stream(*chunk, name);
+      if (!stream)
+        return false;
+      data = reader->read_stream(*chunk, *stream);
+      return true;
+    };
+    return streams;
+  }
+
+  // tar 归档只能整体解压
+  streams.source = archives[i];
+  string tar;
+  {
+    MappedFile file(archives[i]);
+    codec_decompress(file.data(), file.size(), tar);
+  }
+  auto archive = make_shared<ChunkArchive>(ChunkArchive::from_tar(tar));
+  for (auto &[name, data] : archive->entries())
+    streams.names.push_back(name);
+  streams.read = [archive](const string &name, string &data) {
+    for (auto &[entry_name, entry_data] : archive->entries()) {
+      if (entry_name == name) {
+        data = move(entry_data);
+        return true;
+      }
+    }
+    return false;
+  };
+  return streams;
+}
+
+// 解压结果写到 -o 指定的文件，未指定或为 - 时写到标准输出
+static FILE *open_output(const Args &args) {
+  if (args.output_dir.empty() || args.output_dir == "-")
+    return stdout;
+  FILE *out = fopen(args.output_dir.c_str(), "wb");
+  if (!out)
+    handle_error(
+        format("Failed to create output file: %s", args.output_dir.c_str()));
+  return out;
+}
+
+static void close_output(FILE *out) {
+  if (fflush(out) != 0 || (out != stdout && fclose(out) != 0))
+    handle_error("Failed to write decompressed output");
+}
+
+void decompress_logs(const Args &args) {
+  auto start_time = chr::steady_clock::now();
+
+  auto input = open_input(args.input_file);
+  size_t chunk_count = input.chunk_count();
+  if (input.container)
+    cerr << "Container codec: " << codec_name(input.container->codec())
+         << endl;
+  cerr << "Decompressing " << chunk_count << " chunks" << endl;
+  FILE *out = open_output(args);
+
+  // 各块并行还原，写出线程按块号重新排序后顺序写出
+  BoundedQueue<DecodeTask> decode_queue(args.num_threads),
+      write_queue(args.num_threads * 2);
+  StagePool<DecodeTask> decode_pool("Decode", args.num_threads),
+      write_pool("Write", 1);
+
+  decode_pool.start(decode_queue, &write_queue, [&input](DecodeTask &t) {
+    ChunkDecoder decoder(input.streams(t.seq));
+    t.line_count = decoder.line_count();
+    decoder.decode(t.output);
+  });
+
+  // 某一块解码很慢时，后续块会在 pending 中堆积。
+  // 只有块号小于 next_seq + window 时才派发，限制同时在内存中的块数
+  size_t window = max<size_t>(args.num_threads, 1) * 2;
+  size_t next_seq = 0, total_lines = 0, total_bytes = 0;
+  mutex seq_mtx;
+  condition_variable seq_advanced;
+  map<size_t, DecodeTask> pending;
+  write_pool.start(write_queue, nullptr, [&](DecodeTask &t) {
+    pending.emplace(t.seq, move(t));
+    size_t written = next_seq;
+    for (auto it = pending.begin();
+         it != pending.end() && it->first == written;
+         it = pending.erase(it), ++written) {
+      auto &output = it->second.output;
+      if (fwrite(output.data(), 1, output.size(), out) != output.size())
+        handle_error("Failed to write decompressed output");
+      total_lines += it->second.line_count;
+      total_bytes += output.size();
+    }
+    if (written != next_seq) {
+      lock_guard<mutex> lock(seq_mtx);
+      next_seq = written;
+      seq_advanced.notify_one();
+    }
+  });
+
+  for (size_t i = 0; i < chunk_count; ++i) {
+    {
+      unique_lock<mutex> lock(seq_mtx);
+      seq_advanced.wait(lock, [&] { return i < next_seq + window; });
+    }
+    DecodeTask task;
+    task.seq = i;
+    decode_queue.push(move(task));
+  }
+  decode_queue.close();
+
+  decode_pool.join();
+  write_pool.join();
+  close_output(out);
+
+  // 标准输出可能就是解压结果，统计信息一律打印到标准错误
+  decode_pool.report(cerr);
+  write_pool.report(cerr);
+
+  // 打印耗时与吞吐量（按还原后的字节数计算）
+  auto elapsed = chr::duration_cast<chr::microseconds>(
+      chr::steady_clock::now() - start_time);
+  double seconds = elapsed.count() / 1e6;
+  cerr << "Decompressed " << total_lines << " lines, " << total_bytes
+       << " bytes in " << elapsed.count() / 1000 << "ms (" << fixed
+       << setprecision(3) << (seconds > 0 ? total_bytes / seconds / 1e9 : 0.0)
+       << " GB/s)" << endl;
+}
+
+string read_log_lines(const string &path, uint64_t first_line,
+                      uint64_t count) {
+  auto input = open_input(path);
+  uint64_t end_line =
+      count > UINT64_MAX - first_line ? UINT64_MAX : first_line + count;
+  string output;
+
+  // 解码从 chunk 起的块，直到凑够所需的行
+  auto decode_from = [&](size_t chunk, uint64_t chunk_first_line) {
+    for (; chunk < input.chunk_count() && chunk_first_line < end_line;
+         ++chunk) {
+      ChunkDecoder decoder(input.streams(chunk));
+      uint64_t chunk_end = chunk_first_line + decoder.line_count();
+      if (chunk_end > first_line) {
+        uint64_t first = max(first_line, chunk_first_line);
+        decoder.decode(output, first - chunk_first_line,
+                       min(end_line, chunk_end) - first);
+      }
+      chunk_first_line = chunk_end;
+    }
+  };
+
+  if (input.container) {
+    // 目录记录了每个块的行号范围，二分定位
+    auto &chunks = input.container->chunks();
+    auto it = upper_bound(chunks.begin(), chunks.end(), first_line,
+                          [](uint64_t line, const ChunkEntry &chunk) {
+                            return line < chunk.first_line;
+                          });
+    if (it != chunks.begin())
+      --it;
+    if (it != chunks.end())
+      decode_from(it - chunks.begin(), it->first_line);
+  } else if (input.chunk_count() > 0) {
+    // tar 归档没有目录，除最后一块外每块行数相同，由第一块得到块大小
+    uint64_t chunk_size = ChunkDecoder(input.streams(0)).line_count();
+    size_t chunk = chunk_size ? first_line / chunk_size : 0;
+    decode_from(chunk, chunk * chunk_size);
+  }
+  return output;
+}
+
+void get_logs(const Args &args) {
+  auto start_time = chr::steady_clock::now();
+
+  // 命令行中的行号从 1 开始，与 grep -n / sed -n 一致
+  auto output =
+      read_log_lines(args.input_file, args.get_line - 1, args.get_count);
+  FILE *out = open_output(args);
+  if (fwrite(output.data(), 1, output.size(), out) != output.size())
+    handle_error("Failed to write decompressed output");
+  close_output(out);
+
+  auto elapsed = chr::duration_cast<chr::microseconds>(
+      chr::steady_clock::now() - start_time);
+  cerr << "Retrieved " << count(output.begin(), output.end(), '\n')
+       << " lines in " << fixed << setprecision(3) << elapsed.count() / 1000.0
+       << "ms" << endl;
+}
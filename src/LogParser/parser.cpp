@@ -1,78 +1,91 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/hash/hash.h"
+#include "absl/strings/string_view.h"
 #include "arg.hpp"
 #include "internal/out.hpp"
 #include "typedef.hpp"
+#include "utils/ArenaFPGrowth.hpp"
 #include "utils/Array2.hpp"
 #include "utils/IndexSet.hpp"
-#include "utils/fpgrow.hpp"
+#include "utils/ParallelFor.hpp"
+#include "utils/SubTokenSplitter.hpp"
+#include "utils/SubTokenType.hpp"
+#include "utils/TemplateFingerprint.hpp"
+#include "utils/Timestamp.hpp"
+#include "utils/TokenClassifier.hpp"
+#include "utils/TokenSplitter.hpp"
 #include "utils/pcre2regex.hpp"
 #include <LogParser.hpp>
 #include <algorithm>
+#include <charconv>
 #include <cmath>
 #include <constant.hpp>
 #include <cstddef>
 #include <cstdint>
+#include <chrono>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <map>
 #include <memory>
 #include <ostream>
+#include <sstream>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <utils/util.hpp>
 #include <vector>
 using namespace std;
+namespace chr = std::chrono;
 
-LogParser::LogParser(const Args &args)
-    : args(args), MAIN_TOKEN_RE(R"(([^\s|]+)|(\s)|(\|))"),
-      DYNAMIC_TOKEN_RE(R"(([\p{L}\p{N}]+)|([^\p{L}\p{N}]+))") {
+LogParser::LogParser(const Args &args) : args(args) {
   CLASSIFY_PATTERNS.emplace_back(R"((/[^/ ]*)+|([a-zA-Z]:\\(?:[^\\ ]*\\)*))");
   CLASSIFY_PATTERNS.emplace_back(R"(^\S*\d\S*$)");
 }
-void LogParser::update_output_dir(const string &output_dir) {
-  this->output_dir = output_dir;
+void LogParser::update_output_path(const string &output_path) {
+  archive = ChunkArchive(output_path);
 }
 
-void LogParser::process_chunk(const VecS &chunk, const IndexManager &im,
-                              size_t chunk_idx) {
-
+void LogParser::parse_chunk(const LineSpans &chunk, const IndexManager &im) {
+  // chunk 只包含本块的行，im 记录这些行的全局行号范围
+  runtime_space.reserve(im.len());
   for (size_t i = 0; i < im.len(); i++) {
-    parse_one(chunk[im[i]]);
+    parse_one(chunk[i]);
   }
+}
 
-  token_manager.process_base_dict_for_vec(output_dir);
-
-  DEBUG("pasrser.process_patterns_exp: in")
-  process_patterns_exp();
-  DEBUG("pasrser.process_patterns_exp: out")
+void LogParser::encode_chunk() {
+  token_manager.process_base_dict_for_vec(archive, column_costs,
+                                          args.python_compatible);
 
   DEBUG("pasrser.process_matrix_ndarray_dict: in")
   process_matrix_ndarray_dict();
   DEBUG("pasrser.process_matrix_ndarray_dict: out")
+  if (args.codec_stats)
+    report_column_codecs();
 
   DEBUG("token_manager.process_simple_var_dict: in")
   token_manager.process_simple_var_dict();
   DEBUG("token_manager.process_simple_var_dict: out")
 }
 
-void LogParser::parse_one(const string &log) {
+void LogParser::parse_one(string_view log) {
   // size_t raw_id = raw_id_counter++;
 
   // Call parse_template which now returns all processed information
 
   // Update runtime space
-  VecS total_dynamic_vars;
-  string templ;
-  bool res =
-      parse_template_and_process_dynamic_vars(log, templ, total_dynamic_vars);
+  uint64_t fingerprint;
+  bool res = parse_template_and_process_dynamic_vars(log, fingerprint);
   if (!res) {
+    runtime_space.drop_line();
     return;
   }
   // Get parsed_id and update template index
-  uint32_t parsed_id = manage_template(templ);
-  runtime_space.emplace_back(move(total_dynamic_vars), parsed_id);
+  uint32_t parsed_id = manage_template(fingerprint);
+  runtime_space.finish_line(parsed_id);
   // Update mappings
   // raw_to_parsed_map.push_back(parsed_id);
 }
@@ -97,152 +110,173 @@ void LogParser::parse_one(const string &log) {
 //   return true;
 // }
 
+static constexpr string_view PLACEHOLDER_KEYS[] = {
+    "<a>", "<b>", "<c>", "<d>", "<e>", "<f>", "<g>", "<h>", "<i>",
+    "<j>", "<k>", "<l>", "<m>", "<n>", "<o>", "<*>", "<->"};
+static constexpr uint32_t PLACEHOLDER_COUNT = size(PLACEHOLDER_KEYS);
+
+// 行首时间戳的占位符 <t格式编号>，含数字，原文中的同样写法会作为动态 token
+// 处理而不会留在模板中
+static const vector<string> TIMESTAMP_KEYS = [] {
+  vector<string> keys;
+  for (size_t i = 0; i < timestamp_format_count(); ++i)
+    keys.push_back("<t" + to_string(i) + ">");
+  return keys;
+}();
+
+// 是否含有解码时会被当成占位符的 <a> ~ <o>、<*>，或编码时会被替换的 <->
+static bool has_placeholder_key(string_view token) {
+  for (size_t i = token.find('<');
+       i != string_view::npos && i + 2 < token.size();
+       i = token.find('<', i + 1)) {
+    char key = token[i + 1];
+    if (token[i + 2] == '>' &&
+        ((key >= 'a' && key <= 'o') || key == '*' || key == '-'))
+      return true;
+  }
+  return false;
+}
+
+// 不超过 12 个小写字母，夹在两个 | 之间时与 dict id 标记 |字母| 相同
+static bool is_dict_id_like(string_view token) {
+  return !token.empty() && token.size() <= 12 &&
+         all_of(token.begin(), token.end(),
+                [](char c) { return c >= 'a' && c <= 'z'; });
+}
+
 bool LogParser::parse_template_and_process_dynamic_vars(
-    const string &log, string &templ, VecS &total_dynamic_vars) {
+    string_view log, uint64_t &fingerprint) {
+  // 模板片段只记录为 string_view（指向本行或占位符常量），
+  // 由 manage_template 在需要时才拼接成字符串
+  template_parts.clear();
+  TemplateFingerprint fp;
+  // 空行对应空模板，保证解压后行号不变
   if (log.empty()) {
-    return false;
+    fingerprint = fp.value();
+    return true;
   }
 
-  VecS template_parts;
-  size_t total_len = 0;
-  // 使用正则表达式匹配所有 token
-  for (auto it = MAIN_TOKEN_RE.get_iter(log); !it.end(); it.next()) {
-    auto [start, end] = it.cap();
-    total_len += classify_and_process_token(log.substr(start, end - start),
-                                            template_parts, total_dynamic_vars);
+  // 行首的时间戳整体折算为一个值，其余部分照常切分
+  size_t timestamp_length;
+  int64_t timestamp;
+  int format =
+      args.python_compatible
+          ? -1
+          : match_timestamp(log, timestamp_hint, timestamp_length, timestamp);
+  if (format >= 0) {
+    timestamp_hint = size_t(format);
+    template_parts.push_back(TIMESTAMP_KEYS[format]);
+    fp.add_placeholder(PLACEHOLDER_COUNT + format);
+    token_manager.timestamp_vec[format].push_back(uint64_t(timestamp));
+    log.remove_prefix(timestamp_length);
   }
 
-
-  templ.reserve(total_len);
-  for (const auto &part : template_parts) {
-    templ += part;
-  }
+  auto add_token = [&](string_view token, bool force_var) {
+    int placeholder_index = classify_and_process_token(token);
+    // 留作原文会在解码时被当成占位符的 token 改作 <*> 变量
+    if (placeholder_index < 0 && force_var) {
+      placeholder_index = 15;
+      token_manager.simple_var_dict.emplace(string(token));
+    }
+    if (placeholder_index >= 0) {
+      template_parts.push_back(PLACEHOLDER_KEYS[placeholder_index]);
+      fp.add_placeholder(placeholder_index);
+      runtime_space.add_var(token);
+    } else {
+      template_parts.push_back(token);
+      fp.add_literal(token);
+    }
+  };
+  // 紧跟在 | 之后的小写字母 token，要看到下一个 token 是否为 | 才能决定
+  string_view held;
+  // 按空白字符与 | 切分出所有 token，结果与 MAIN_TOKEN_RE 相同
+  split_tokens(log, [&](string_view token) {
+    if (!held.empty()) {
+      add_token(held, token == "|");
+      held = {};
+    }
+    if (is_dict_id_like(token) && !template_parts.empty() &&
+        template_parts.back() == "|") {
+      held = token;
+      return;
+    }
+    add_token(token, has_placeholder_key(token));
+  });
+  if (!held.empty())
+    add_token(held, false);
+  fingerprint = fp.value();
   return true;
 }
 
-size_t LogParser::classify_and_process_token(string token, VecS &template_parts,
-                                             VecS &total_dynamic_vars) {
-
-  static const VecS keys = {"<a>", "<b>", "<c>", "<d>", "<e>", "<f>",
-                            "<g>", "<h>", "<i>", "<j>", "<k>", "<l>",
-                            "<m>", "<n>", "<o>", "<*>", "<->"};
-
+int LogParser::classify_and_process_token(string_view token) {
   int placeholder_index = -1;
 
-  for (const auto &pat_re : CLASSIFY_PATTERNS) {
-    if (pat_re.match(token)) {
-
-
-      if (is_numeric(token)) {
-        if (token.length() <= 15) {
-
-          placeholder_index = token.length() - 1;
-
+  // 一次扫描得到字符类别。纯 ASCII 的 token 可以直接判断是否命中
+  // CLASSIFY_PATTERNS（含 /、含 [a-zA-Z]:\ 或含数字）；
+  // 含非 ASCII 字节时 \d 还包括其它 Unicode 数字，仍交给 PCRE2
+  auto flags = classify_token_chars(token);
+  bool matched;
+  if (!flags.non_ascii) {
+    matched = flags.has_slash || flags.has_digit || has_drive_path(token);
+  } else {
+    matched = any_of(CLASSIFY_PATTERNS.begin(), CLASSIFY_PATTERNS.end(),
+                     [&](const Pcre2Regex &re) { return re.match(token); });
+  }
 
-          token_manager.get_or_register_token_no_split(token, -1, nullptr,
-                                                       nullptr);
-        } else {
-          placeholder_index = 15;
-          token_manager.simple_var_dict.insert(token);
-        }
+  if (matched) {
+    if (flags.all_digit) {
+      if (token.length() <= 15) {
+        placeholder_index = token.length() - 1;
+        token_manager.get_or_register_token_no_split(string(token), -1,
+                                                     nullptr, nullptr);
       } else {
-        bool contains_punctuation = false;
-        bool has_alnum = false;
-        for (auto c : token) {
-          if (contains_punctuation && has_alnum) {
-            break;
-          } else if (!isalnum(c)) {
-            contains_punctuation = true;
-          } else {
-            has_alnum = true;
-          }
-        }
-
-        if (!contains_punctuation) {
-          placeholder_index = 15;
-          token_manager.simple_var_dict.insert(token);
-        } else if (has_alnum) {
-
-            // string non_punctuation_chars;
-            // std::copy_if(token.begin(), token.end(),
-            //              std::back_inserter(non_punctuation_chars),
-            //              [](char c) { return std::isalnum(c); });
-
-          placeholder_index = 16;
-          // 处理动态 token
-          // auto token_vec =
-          process_dynamic_token(token);
-          // if (!token_vec.empty()) {
-          //   dynamic_vecs.push_back(std::move(token_vec));
-          // } else {
-          //   dynamic_vecs.emplace_back();
-          // }
-        } else {
-          // 纯符号 token
-          placeholder_index = -1;
-          // cout << "IN CLASSIFY_AND_PROCESS_TOKEN: token: " << token << endl;
-        }
+        placeholder_index = 15;
+        token_manager.simple_var_dict.emplace(string(token));
       }
-      break;
+    } else if (!flags.has_punct) {
+      placeholder_index = 15;
+      token_manager.simple_var_dict.emplace(string(token));
+    } else if (flags.has_alpha || flags.has_digit) {
+      placeholder_index = 16;
+      // 处理动态 token
+      process_dynamic_token(token);
+    } else {
+      // 纯符号 token
+      placeholder_index = -1;
     }
   }
-
-  if (placeholder_index >= 0) {
-    template_parts.push_back(keys[placeholder_index]);
-    total_dynamic_vars.emplace_back(move(token));
-    return 3;
-  } else {
-    size_t l = token.length();
-    template_parts.emplace_back(move(token));
-    return l;
-  }
+  return placeholder_index;
 }
 
-bool LogParser::process_dynamic_token(const string &token) {
+bool LogParser::process_dynamic_token(string_view token) {
 
   if (token.empty()) {
     return false;
   }
 
-  // static const regex DYNAMIC_TOKEN_RE(R"(([\p{L}\p{N}]+)|([^\p{L}\p{N}]+))");
-
-  string pattern;
+  // 一次扫描同时得到模式与各个子 token：字母数字段替换为 <>，
+  // 并以 "段(序号)" 的形式登记，其余字符原样留在模式中
+  VecS result(1);
+  // 子 token 最多 (len + 1) / 2 个，预留后 pattern 的引用不会失效
+  result.reserve(token.size() / 2 + 2);
+  string &pattern = result[0];
   pattern.reserve(token.size() + 10);
-  VecS parts;
-  parts.reserve(8);
-  int word_index = 0;
-
-  //这里是在分词，每个m就是一个sub-token
-  for (auto match = DYNAMIC_TOKEN_RE.get_iter(token); !match.end();
-       match.next()) {
-    //分组一字母+数字
-    if (match.has_cap(1)) {
-      auto [st, ed] = match.cap(1);
-      auto word =
-          token.substr(st, ed - st) + "(" + to_string(word_index++) + ")";
-      // token_manager.token_frequency[word]++;
-      parts.emplace_back(move(word));
-      pattern += "<>";
-      // cout << "cap 1: " << word << endl;
-    }
-    // 分组二 非字母非数字（如符号）
-    else if (match.has_cap(2)) {
-      auto [st, ed] = match.cap(2);
-      pattern += token.substr(st, ed - st);
-      // cout << "cap 2: " << token.substr(st, ed - st) << endl;
-    } else {
-      // cout << match.has_cap() << endl;
-      handle_error(
-          format("IN PROCESS_DYNAMIC_TOKEN - ERROR in unknown group, token: %s",
-                 token.c_str()));
+  size_t word_index = 0;
+  split_sub_tokens(token, [&](string_view run, bool is_alnum) {
+    if (!is_alnum) {
+      pattern += run;
+      return;
     }
-  }
-
-  VecS result;
-  result.reserve(parts.size() + 1);
-  result.emplace_back(move(pattern));
-  for (int i = 0; i < parts.size(); i++)
-    result.emplace_back(move(parts[i]));
+    pattern += "<>";
+    char index[24];
+    index[0] = '(';
+    auto res = to_chars(index + 1, index + sizeof(index) - 1, word_index++);
+    *res.ptr++ = ')';
+    auto &word = result.emplace_back();
+    word.reserve(run.size() + (res.ptr - index));
+    word += run;
+    word.append(index, res.ptr - index);
+  });
 
   if (result.size() <= 1) {
     string error_msg = result.empty()
@@ -254,7 +288,7 @@ bool LogParser::process_dynamic_token(const string &token) {
   // Update dictionaries
   auto &container = sole_pat_dict[result[0]];
   container.set.insert(result);
-  container.vec.emplace_back(result);
+  container.vec.emplace_back(move(result));
   return true;
 }
 
@@ -269,466 +303,584 @@ uint32_t LogParser::manage_template(const string &templ) {
   return id;
 }
 
+uint32_t LogParser::manage_template(uint64_t fingerprint) {
+  // 绝大多数行命中已有模板：逐段比对确认不是哈希冲突，不拼接字符串
+  auto it = fingerprint_index.find(fingerprint);
+  if (it != fingerprint_index.end()) {
+    const string &templ = parsed_log_map[it->second];
+    size_t pos = 0;
+    bool same = true;
+    for (string_view part : template_parts) {
+      if (templ.compare(pos, part.size(), part.data(), part.size()) != 0) {
+        same = false;
+        break;
+      }
+      pos += part.size();
+    }
+    if (same && pos == templ.size()) {
+      return it->second;
+    }
+  }
+
+  // 首次出现的指纹（或冲突）才拼接模板。不同的片段序列可能拼出同一个模板，
+  // 仍以字符串为准分配 id
+  size_t total_len = 0;
+  for (string_view part : template_parts) {
+    total_len += part.size();
+  }
+  string templ;
+  templ.reserve(total_len);
+  for (string_view part : template_parts) {
+    templ += part;
+  }
+  uint32_t id = manage_template(templ);
+  if (it == fingerprint_index.end()) {
+    fingerprint_index.emplace(fingerprint, id);
+  }
+  return id;
+}
+
 void LogParser::process_patterns_exp() {
   auto &sole_pat = sole_pat_dict.to_vector();
   size_t len = sole_pat.size();
+  // 各个 sole pattern 互不依赖，先并行挖掘，结果记录在 mined 中；
+  // 再按原顺序合并，id 分配与串行执行完全一致。
+  // 行数 * 列数大的先处理，避免最后只剩一个大任务
+  vector<size_t> order(len);
+  vector<size_t> cost(len);
   for (size_t i = 0; i < len; i++) {
-    auto &sole_pat_key = sole_pat[i].first;
-    auto &sole_pat_vec = sole_pat[i].second.vec;
-    auto &sole_pat_set = sole_pat[i].second.set;
+    order[i] = i;
+    auto &vec = sole_pat[i].second.vec;
+    cost[i] = vec.empty() ? 0 : vec.size() * vec[0].size();
+  }
+  stable_sort(order.begin(), order.end(),
+              [&](size_t a, size_t b) { return cost[a] > cost[b]; });
+
+  vector<MinedPattern> mined(len);
+  parallel_for(len, args.mine_pattern_threads, [&](size_t k) {
+    mine_sole_pattern(sole_pat[order[k]].first, sole_pat[order[k]].second,
+                      mined[order[k]]);
+  });
+  for (auto &result : mined) {
+    merge_mined_pattern(result);
+  }
+}
 
-    if (sole_pat_vec.empty()) {
-      continue;
-    } else if (sole_pat_vec.size() == 1) {
-      // 直接合成注册
-      string token;
-      generate_rules(sole_pat_vec[0], token);
-      exp_rules_dict.emplace(token, token);
-      token_manager.simple_var_dict.emplace(move(token));
+void LogParser::mine_sole_pattern(const string &sole_pat_key,
+                                  PatternContianer &container,
+                                  MinedPattern &mined) {
+  auto &sole_pat_vec = container.vec;
+  auto &sole_pat_set = container.set;
+
+  if (sole_pat_vec.empty()) {
+    return;
+  } else if (sole_pat_vec.size() == 1) {
+    // 直接合成注册
+    string token;
+    generate_rules(sole_pat_vec[0], token);
+    mined.exp_rules.emplace_back(token, token);
+    mined.simple_vars.push_back(move(token));
+    return;
+  }
+  DEBUG("sole_pat_vec = (%lu, %lu)", sole_pat_vec.size(),
+        sole_pat_vec[0].size());
+  Array2<string> arr(sole_pat_vec);
+
+  // =========================================================================
+  //  第一阶段：分析每个槽位并收集统计数据
+  // =========================================================================
+  DEBUG("first phase")
+  vector<SlotStats> slot_stat_vec;
+  slot_stat_vec.reserve(arr.get_col_count() - 1);
+  VecS update_pat_vec = {sole_pat_key};
+  vector<size_t> keep_column_idx;
+  size_t all_rows = arr.get_row_count();
+
+  for (size_t col_idx = 1; col_idx < arr.get_col_count(); ++col_idx) {
+
+    auto &values = arr.values(col_idx);
+    if (values.size() == 1) {
+      // 唯一值，加入 update_pat_vec
+      update_pat_vec.push_back(values[0]);
       continue;
+    } else {
+      keep_column_idx.push_back(col_idx);
     }
-    DEBUG("sole_pat_vec = (%lu, %lu)", sole_pat_vec.size(),
-          sole_pat_vec[0].size());
-    Array2<string> arr(&sole_pat_vec);
-
-    // =========================================================================
-    //  第一阶段：分析每个槽位并收集统计数据
-    // =========================================================================
-    DEBUG("first phase")
-    vector<SlotStats> slot_stat_vec;
-    slot_stat_vec.reserve(arr.get_col_count() - 1);
-    VecS update_pat_vec = {sole_pat_key};
-    vector<size_t> keep_column_idx;
-    size_t all_rows = arr.get_row_count();
-
-    for (size_t col_idx = 1; col_idx < arr.get_col_count(); ++col_idx) {
-
-      const auto &column_index = arr.get_column(col_idx);
-      // 统计频次
-      map<string, uint32_t> counts_map;
-      for (size_t i = 0; i < column_index.size(); ++i) {
-        counts_map[arr[column_index.get(i)]] += 1;
-      }
 
-      if (counts_map.size() == 1) {
-        // 唯一值，加入 update_pat_vec
-        update_pat_vec.push_back(arr[column_index.get(0)]);
-        continue;
-      } else {
-        keep_column_idx.push_back(col_idx);
-      }
+    // 统计频次：先按编号计数，每个不同的值只插入一次
+    vector<uint32_t> counts(values.size(), 0);
+    for (auto code : arr.codes(col_idx))
+      ++counts[code];
+    map<string, uint32_t> counts_map;
+    for (size_t code = 0; code < values.size(); ++code)
+      counts_map.emplace(values[code], counts[code]);
 
-      auto &slot_stats = slot_stat_vec.emplace_back();
-      slot_stats.column_index = col_idx;
-      slot_stats.unique_values_count = counts_map.size();
+    auto &slot_stats = slot_stat_vec.emplace_back();
+    slot_stats.column_index = col_idx;
+    slot_stats.unique_values_count = counts_map.size();
 
-      // 自动计算超参数
-      // size_t min_peak_height = rows / slot_stats.unique_values_count;
-      // size_t min_peak_distance = 1;
+    // 自动计算超参数
+    // size_t min_peak_height = rows / slot_stats.unique_values_count;
+    // size_t min_peak_distance = 1;
 
-      // 找出代表性值
-      uint32_t rep_sum = 0;
-      find_representative_values(counts_map, all_rows,
-                                 slot_stats.representative_values, rep_sum);
+    // 找出代表性值
+    uint32_t rep_sum = 0;
+    find_representative_values(counts_map, all_rows,
+                               slot_stats.representative_values, rep_sum);
 
-      // 计算优势比
-      slot_stats.dominance_ratio = double(rep_sum) / all_rows;
+    // 计算优势比
+    slot_stats.dominance_ratio = double(rep_sum) / all_rows;
 
-      // 计算信息熵
-      slot_stats.entropy = calculate_entropy(counts_map, all_rows);
-    }
+    // 计算信息熵
+    slot_stats.entropy = calculate_entropy(counts_map, all_rows);
+  }
 
-    // =========================================================================
-    //  第二阶段：选择最佳标志位
-    // =========================================================================
-    DEBUG("second phase")
-    if (slot_stat_vec.empty()) {
-      string final_pat_key;
-      generate_rules(update_pat_vec, final_pat_key);
-      add_to_exp_rules_dict(sole_pat_set, final_pat_key);
-      token_manager.simple_var_dict.emplace(move(final_pat_key));
+  // =========================================================================
+  //  第二阶段：选择最佳标志位
+  // =========================================================================
+  DEBUG("second phase")
+  if (slot_stat_vec.empty()) {
+    string final_pat_key;
+    generate_rules(update_pat_vec, final_pat_key);
+    add_to_exp_rules_dict(sole_pat_set, final_pat_key, mined);
+    mined.simple_vars.push_back(move(final_pat_key));
 
-      continue;
+    return;
 
-    } else if (slot_stat_vec.size() == 1) {
-      string final_pat_key;
-      generate_rules(update_pat_vec, final_pat_key);
-      add_to_exp_rules_dict(sole_pat_set, final_pat_key);
-      add_to_matrix_ndarray_dict(update_pat_vec, sole_pat_set, keep_column_idx,
-                                 final_pat_key, arr);
-      continue;
-    }
+  } else if (slot_stat_vec.size() == 1) {
+    string final_pat_key;
+    generate_rules(update_pat_vec, final_pat_key);
+    add_to_exp_rules_dict(sole_pat_set, final_pat_key, mined);
+    add_to_matrix_ndarray_dict(update_pat_vec, sole_pat_set, keep_column_idx,
+                               final_pat_key, arr, mined);
+    return;
+  }
 
-    sort(slot_stat_vec.begin(), slot_stat_vec.end(),
-         [](const SlotStats &a, const SlotStats &b) {
-           if (a.unique_values_count != b.unique_values_count) {
-             return a.unique_values_count <
-                    b.unique_values_count; // 按唯一值数量升序排序
-           }
-
-           if (a.dominance_ratio != b.dominance_ratio) {
-             return a.dominance_ratio > b.dominance_ratio; // 按优势比降序排序
-           }
-
-           return a.entropy < b.entropy; // 按熵升序排序
-         });
-
-    auto &best_slot_stats = slot_stat_vec[0];
-    DEBUG("best_slot_stats: column_index=%lu, unique_values_count=%lu",
-          best_slot_stats.column_index, best_slot_stats.unique_values_count)
-
-    // =========================================================================
-    //  第三阶段：基于最佳标志位进行分类和输出
-    // =========================================================================
-    DEBUG("third phase")
-    auto best_column_index = arr.get_column(best_slot_stats.column_index);
-    VecS new_patterns, new_pat_keys;
-
-    if (best_slot_stats.representative_values.empty() ||
-        best_slot_stats.representative_values.size() >=
-            args.rep_val_threshold ||
-        best_slot_stats.dominance_ratio <= args.dom_ratio) {
-      DEBUG("best representative_values.size=%lu, dominance_ratio=%lf; "
-            "update_pat_vec.size=%lu",
-            best_slot_stats.representative_values.size(),
-            best_slot_stats.dominance_ratio, update_pat_vec.size())
-      string final_pat_key;
-      generate_rules(update_pat_vec, final_pat_key);
-      add_to_exp_rules_dict(sole_pat_set, final_pat_key);
-      add_to_matrix_ndarray_dict(update_pat_vec, sole_pat_set, keep_column_idx,
-                                 final_pat_key, arr);
-      continue;
-    }
-    DEBUG("best representative values is not empty")
-
-    uint32_t new_posotion = best_slot_stats.column_index;
-    string mined_pat_key;
-    generate_rules(update_pat_vec, mined_pat_key);
-    bool is_unique_values_count_less_than_x =
-        best_slot_stats.unique_values_count <= args.zeta;
-
-    DEBUG("is_unique_values_count_less_than_x: %s",
-          is_unique_values_count_less_than_x ? "true" : "false")
-    if (is_unique_values_count_less_than_x) {
-      IndexSet<string> all_unique_set;
-      for (const auto &it : best_slot_stats.representative_values)
-        all_unique_set.insert(it);
-
-      // 处理离群点数据
-      for (size_t i = 0; i < best_column_index.size(); ++i) {
-        const auto &point = arr[best_column_index.get(i)];
-        if (!all_unique_set.contains(point)) {
-          all_unique_set.insert(point);
-        }
+  sort(slot_stat_vec.begin(), slot_stat_vec.end(),
+       [](const SlotStats &a, const SlotStats &b) {
+         if (a.unique_values_count != b.unique_values_count) {
+           return a.unique_values_count <
+                  b.unique_values_count; // 按唯一值数量升序排序
+         }
+
+         if (a.dominance_ratio != b.dominance_ratio) {
+           return a.dominance_ratio > b.dominance_ratio; // 按优势比降序排序
+         }
+
+         return a.entropy < b.entropy; // 按熵升序排序
+       });
+
+  auto &best_slot_stats = slot_stat_vec[0];
+  DEBUG("best_slot_stats: column_index=%lu, unique_values_count=%lu",
+        best_slot_stats.column_index, best_slot_stats.unique_values_count)
+
+  // =========================================================================
+  //  第三阶段：基于最佳标志位进行分类和输出
+  // =========================================================================
+  DEBUG("third phase")
+  VecS new_patterns, new_pat_keys;
+
+  if (best_slot_stats.representative_values.empty() ||
+      best_slot_stats.representative_values.size() >=
+          args.rep_val_threshold ||
+      best_slot_stats.dominance_ratio <= args.dom_ratio) {
+    DEBUG("best representative_values.size=%lu, dominance_ratio=%lf; "
+          "update_pat_vec.size=%lu",
+          best_slot_stats.representative_values.size(),
+          best_slot_stats.dominance_ratio, update_pat_vec.size())
+    string final_pat_key;
+    generate_rules(update_pat_vec, final_pat_key);
+    add_to_exp_rules_dict(sole_pat_set, final_pat_key, mined);
+    add_to_matrix_ndarray_dict(update_pat_vec, sole_pat_set, keep_column_idx,
+                               final_pat_key, arr, mined);
+    return;
+  }
+  DEBUG("best representative values is not empty")
+
+  uint32_t new_posotion = best_slot_stats.column_index;
+  string mined_pat_key;
+  generate_rules(update_pat_vec, mined_pat_key);
+  bool is_unique_values_count_less_than_x =
+      best_slot_stats.unique_values_count <= args.zeta;
+
+  DEBUG("is_unique_values_count_less_than_x: %s",
+        is_unique_values_count_less_than_x ? "true" : "false")
+  if (is_unique_values_count_less_than_x) {
+    IndexSet<string> all_unique_set;
+    for (const auto &it : best_slot_stats.representative_values)
+      all_unique_set.insert(it);
+
+    // 处理离群点数据，列的值表即按首次出现的顺序
+    for (const auto &point : arr.values(best_slot_stats.column_index)) {
+      if (!all_unique_set.contains(point)) {
+        all_unique_set.insert(point);
       }
+    }
 
-      const auto &all_unique_values = all_unique_set.to_vector();
+    const auto &all_unique_values = all_unique_set.to_vector();
 
-      add_to_new_patterns(update_pat_vec, all_unique_values, new_patterns,
-                          new_pat_keys);
+    add_to_new_patterns(update_pat_vec, all_unique_values, new_patterns,
+                        new_pat_keys);
 
-    } else {
-      add_to_new_patterns(update_pat_vec, best_slot_stats.representative_values,
-                          new_patterns, new_pat_keys);
+  } else {
+    add_to_new_patterns(update_pat_vec, best_slot_stats.representative_values,
+                        new_patterns, new_pat_keys);
+  }
+
+  DEBUG("get missing matrix")
+  //先根据keep_column_idx来获得missing_matrix
+  auto missing_matrix = arr.get_columns(keep_column_idx);
+
+  //然后根据new_pat_keys来继续划分missing_matrix_for_final_pat_key,具体来说就是将检查new_position对应的那列的值，如果值在new_pat_keys中，则将该行保存到新的missing_matrix中
+  // target_column_idx是new_position在keep_column_idx中的位置
+  // 目标列每个值的编号对应的 new_pat_keys 下标，一次扫描即可按键把行分组
+  auto &target_values = arr.values(new_posotion);
+  vector<uint32_t> key_of_code(target_values.size(), UINT32_MAX);
+  {
+    absl::flat_hash_map<absl::string_view, uint32_t> key_index;
+    for (size_t index = 0; index < new_pat_keys.size(); index++)
+      key_index.emplace(new_pat_keys[index], uint32_t(index));
+    for (size_t code = 0; code < target_values.size(); code++) {
+      auto it = key_index.find(target_values[code]);
+      if (it != key_index.end())
+        key_of_code[code] = it->second;
+    }
+  }
+  vector<vector<size_t>> key_rows(new_pat_keys.size());
+  auto &target_codes = arr.codes(new_posotion);
+  for (size_t j = 0; j < target_codes.size(); j++) {
+    if (auto key = key_of_code[target_codes[j]]; key != UINT32_MAX)
+      key_rows[key].push_back(j);
+  }
+  // size_t all_rows = arr.get_row_count();
+  vector<bool> row_deleted(all_rows, false);
+  size_t deleted_rows = 0;
+
+  // 要区分出哪些行是对应new_pat_keys的
+  for (size_t index = 0; index < new_pat_keys.size(); index++) {
+    auto &new_pat = new_pat_keys[index];
+    auto &filtered_rows = key_rows[index];
+    for (auto j : filtered_rows) {
+      row_deleted[j] = true;
+      ++deleted_rows;
     }
 
-    DEBUG("get missing matrix")
-    //先根据keep_column_idx来获得missing_matrix
-    auto missing_matrix = arr.get_columns(keep_column_idx);
-
-    //然后根据new_pat_keys来继续划分missing_matrix_for_final_pat_key,具体来说就是将检查new_position对应的那列的值，如果值在new_pat_keys中，则将该行保存到新的missing_matrix中
-    // target_column_idx是new_position在keep_column_idx中的位置
-    auto target_column_idx = arr.get_column(new_posotion);
-    // size_t all_rows = arr.get_row_count();
-    absl::flat_hash_set<size_t> rows_to_delete;
-
-    // 要区分出哪些行是对应new_pat_keys的
-    for (size_t index = 0; index < new_pat_keys.size(); index++) {
-      auto &new_pat = new_pat_keys[index];
-      vector<size_t> filtered_rows;
-      //
-      for (size_t j = 0; j < target_column_idx.size(); j++) {
-        if (arr[target_column_idx.get(j)] == new_pat) {
-          rows_to_delete.insert(j);
-          filtered_rows.push_back(j);
-        }
+    if (!filtered_rows.empty()) {
+      DEBUG("filtered_rows size: %lu", filtered_rows.size())
+      vector<size_t> new_keep_column_idx(keep_column_idx.size() - 1);
+      for (size_t j = 0, k = 0; j < keep_column_idx.size(); j++) {
+        if (keep_column_idx[j] == new_posotion)
+          continue;
+        new_keep_column_idx[k++] = keep_column_idx[j];
       }
 
-      if (!filtered_rows.empty()) {
-        DEBUG("filtered_rows size: %lu", filtered_rows.size())
-        vector<size_t> new_keep_column_idx(keep_column_idx.size() - 1);
-        for (size_t j = 0, k = 0; j < keep_column_idx.size(); j++) {
-          if (keep_column_idx[j] == new_posotion)
-            continue;
-          new_keep_column_idx[k++] = keep_column_idx[j];
+      // 形状应该为 filtered_rows.size() * (keep_column_idx.size() - 1)
+      auto new_missing_matrix = arr.get_columns(new_keep_column_idx);
+      new_missing_matrix.set_row_index(filtered_rows);
+      auto row_len = new_missing_matrix.get_row_count(),
+           col_len = new_missing_matrix.get_col_count();
+
+      // 按各列的编号去重，按首次出现的顺序保留不同的行
+      DEBUG("row_len: %lu, col_len: %lu", row_len, col_len)
+      absl::flat_hash_set<vector<uint32_t>> seen_rows;
+      vector<vector<uint32_t>> distinct_rows;
+      for (size_t j = 0; j < row_len; j++) {
+        vector<uint32_t> row_codes;
+        row_codes.reserve(col_len);
+        for (size_t k = 0; k < col_len; k++) {
+          row_codes.push_back(arr.code(new_missing_matrix.get(j, k)));
         }
+        if (seen_rows.insert(row_codes).second)
+          distinct_rows.push_back(move(row_codes));
+      }
 
-        // 形状应该为 filtered_rows.size() * (keep_column_idx.size() - 1)
-        auto new_missing_matrix = arr.get_columns(new_keep_column_idx);
-        new_missing_matrix.set_row_index(filtered_rows);
-        auto row_len = new_missing_matrix.get_row_count(),
-             col_len = new_missing_matrix.get_col_count();
-
-        // 可优化 TODO
-        DEBUG("row_len: %lu, col_len: %lu", row_len, col_len)
-        absl::flat_hash_set<VecS> new_missing_matrix_hashset;
-        for (size_t j = 0; j < row_len; j++) {
-          VecS tmp_vec;
-          tmp_vec.reserve(col_len);
+      size_t min_support = distinct_rows.size();
+      auto new_pattern = new_patterns[index];
+      VecS updated_fp_vec;
+
+      if (col_len < 15) {
+        // fp_growth挖掘，不同列中相同的值是同一项
+        DEBUG("start fp_growth")
+        FPItemIds items;
+        vector<vector<uint32_t>> item_of_code(col_len);
+        for (size_t k = 0; k < col_len; k++)
+          item_of_code[k].assign(arr.values(new_keep_column_idx[k]).size(),
+                                 UINT32_MAX);
+        ArenaFPGrowth fp_growth(min_support);
+        fp_growth.reserve(distinct_rows.size(), distinct_rows.size() * col_len);
+        vector<uint32_t> row_ids;
+        for (auto &row_codes : distinct_rows) {
+          row_ids.clear();
           for (size_t k = 0; k < col_len; k++) {
-            tmp_vec.push_back(arr[new_missing_matrix.get(j, k)]);
+            auto &id = item_of_code[k][row_codes[k]];
+            if (id == UINT32_MAX)
+              id = items.add(arr.values(new_keep_column_idx[k])[row_codes[k]]);
+            row_ids.push_back(id);
           }
-          new_missing_matrix_hashset.emplace(move(tmp_vec));
+          fp_growth.add_transaction(row_ids.data(), row_ids.size());
         }
-
-        size_t min_support = new_missing_matrix_hashset.size();
-        auto new_pattern = new_patterns[index];
-        vector<shared_ptr<string>> updated_fp_vec;
-
-        if (col_len < 15) {
-          // 构建matrix_vec
-          vector<vector<shared_ptr<string>>> matrix_vec;
-          matrix_vec.reserve(new_missing_matrix_hashset.size());
-          for (auto &vec : new_missing_matrix_hashset) {
-            vector<shared_ptr<string>> row_vec;
-            row_vec.reserve(vec.size());
-            for (auto &item : vec) {
-              row_vec.push_back(make_shared<string>(item));
-            }
-            matrix_vec.emplace_back(move(row_vec));
+        auto patterns = fp_growth.run(items.order());
+        DEBUG("fp_growth end, patterns size: %lu", patterns.size())
+        if (!patterns.empty()) {
+          size_t best_pat_idx = 0;
+          for (int i = 1; i < patterns.size(); i++) {
+            if (patterns[i].first.size() >
+                patterns[best_pat_idx].first.size())
+              best_pat_idx = i;
           }
-          // fp_growth挖掘
-          DEBUG("start fp_growth")
-          FPGrowth fp_growth(move(matrix_vec), min_support);
-          auto patterns = fp_growth.run();
-          DEBUG("fp_growth end, patterns size: %lu", patterns.size())
-          if (!patterns.empty()) {
-            size_t best_pat_idx = 0;
-            for (int i = 1; i < patterns.size(); i++) {
-              if (patterns[i].first.size() >
-                  patterns[best_pat_idx].first.size())
-                best_pat_idx = i;
-            }
-            auto &fp_new_pat = patterns[best_pat_idx].first;
-            auto new_pat_vec = update_pat_vec;
-            new_pat_vec.reserve(new_pat_vec.size() + fp_new_pat.size() + 1);
-            new_pat_vec.push_back(new_pat);
-            for (auto item : fp_new_pat) {
-              DEBUG("pattern: %s", item->c_str())
-              new_pat_vec.push_back(*item);
-            }
-            updated_fp_vec = move(fp_new_pat);
-            generate_rules(new_pat_vec, new_pattern);
+          auto &fp_new_pat = patterns[best_pat_idx].first;
+          auto new_pat_vec = update_pat_vec;
+          new_pat_vec.reserve(new_pat_vec.size() + fp_new_pat.size() + 1);
+          new_pat_vec.push_back(new_pat);
+          for (auto id : fp_new_pat) {
+            DEBUG("pattern: %.*s", int(items[id].size()), items[id].data())
+            new_pat_vec.emplace_back(items[id]);
+            updated_fp_vec.emplace_back(items[id]);
           }
+          generate_rules(new_pat_vec, new_pattern);
         }
+      }
 
-        auto tmp_vec = update_pat_vec;
-        tmp_vec.reserve(tmp_vec.size() + updated_fp_vec.size() + 1);
-        for (auto item : updated_fp_vec) {
-          tmp_vec.push_back(*item);
-        }
-        tmp_vec.push_back(new_pat);
-        size_t tmp_size = tmp_vec.size();
-        DEBUG("tmp_vec size: %lu", tmp_size)
-        for (auto &token : new_missing_matrix_hashset) {
-          copy(token.begin(), token.end(), back_inserter(tmp_vec));
-          string token_str;
-          generate_rules(tmp_vec, token_str);
-          exp_rules_dict.emplace(move(token_str), new_pattern);
-          tmp_vec.resize(tmp_size);
-        }
-
-        //接下来需要修改，因为new_pattern已经变了
-        //注册pattern-id
-        DEBUG("new_pattern: %s", new_pattern.c_str())
-        uint64_t dict_id;
-        token_manager.get_or_register_token_no_split(new_pattern, 0, nullptr,
-                                                     &dict_id);
-
-        vector<bool> has_leading_zero_or_big_number_vec;
-        vector<bool> is_numeric_vec;
-        vector<int32_t> position_length;
-        absl::flat_hash_set<size_t> columns_to_remove;
-        has_leading_zero_or_big_number_vec.reserve(col_len);
-        is_numeric_vec.reserve(col_len);
-        position_length.reserve(col_len);
-
-        DEBUG("for new_missing_matrix do ... col_len=%lu", col_len)
-        //遍历missing_matrix_for_final_pat_key的每一列，获得每一列的unique的值的个数
-        for (size_t col_idx = 0; col_idx < col_len; ++col_idx) {
-          DEBUG("loop col_idx: %lu", col_idx)
-          IndexSet<string> unique_set;
-          for (size_t i = 0; i < row_len; ++i)
-            unique_set.insert(arr[new_missing_matrix.get(i, col_idx)]);
-          auto &unique_values = unique_set.to_vector();
-
-          DEBUG("unique_values size: %lu, update_pat_vec size: %lu",
-                unique_values.size(), update_pat_vec.size())
-
-          if (!updated_fp_vec.empty()) {
-            bool should_remove_column = false;
-            for (auto ele : updated_fp_vec) {
-              if (unique_set.contains(*ele)) {
-                should_remove_column = true;
-                break;
-              }
-            }
-            if (should_remove_column) {
-              // new_keep_column_idx的index
-              DEBUG("should remove column: %lu", col_idx)
-              columns_to_remove.insert(col_idx);
-              continue;
-            }
-          }
-
-          absl::flat_hash_set<size_t> length_vec;
-          bool is_num = true;
-          bool has_leading_zero_or_big_number = false;
-          DEBUG("for unique_values do ...")
-          for (const auto &ele : unique_values) {
-            string pur_ele = ele.substr(0, ele.find('('));
-
-            if (is_num && !is_numeric(pur_ele)) {
-              is_num = false;
-            }
-
-            size_t len = pur_ele.size();
-            length_vec.insert(len);
+      auto tmp_vec = update_pat_vec;
+      tmp_vec.reserve(tmp_vec.size() + updated_fp_vec.size() + col_len + 1);
+      for (auto &item : updated_fp_vec) {
+        tmp_vec.push_back(item);
+      }
+      tmp_vec.push_back(new_pat);
+      size_t tmp_size = tmp_vec.size();
+      DEBUG("tmp_vec size: %lu", tmp_size)
+      for (auto &row_codes : distinct_rows) {
+        for (size_t k = 0; k < col_len; k++)
+          tmp_vec.push_back(arr.values(new_keep_column_idx[k])[row_codes[k]]);
+        string token_str;
+        generate_rules(tmp_vec, token_str);
+        mined.exp_rules.emplace_back(move(token_str), new_pattern);
+        tmp_vec.resize(tmp_size);
+      }
 
-            if (is_num && (len > 15 || (len > 1 && pur_ele[0] == '0'))) {
-              has_leading_zero_or_big_number = true;
+      //接下来需要修改，因为new_pattern已经变了
+      //注册pattern-id
+      DEBUG("new_pattern: %s", new_pattern.c_str())
+      size_t matrix_record = mined.matrices.size();
+      mined.matrices.push_back({new_pattern, 0, false, false, {}});
+
+      vector<bool> has_leading_zero_or_big_number_vec;
+      vector<bool> is_numeric_vec;
+      vector<int32_t> position_length;
+      absl::flat_hash_set<size_t> columns_to_remove;
+      has_leading_zero_or_big_number_vec.reserve(col_len);
+      is_numeric_vec.reserve(col_len);
+      position_length.reserve(col_len);
+
+      DEBUG("for new_missing_matrix do ... col_len=%lu", col_len)
+      //遍历missing_matrix_for_final_pat_key的每一列，获得每一列的unique的值的个数
+      for (size_t col_idx = 0; col_idx < col_len; ++col_idx) {
+        DEBUG("loop col_idx: %lu", col_idx)
+        auto &values = arr.values(new_keep_column_idx[col_idx]);
+        auto unique_codes = arr.distinct_codes(new_missing_matrix, col_idx);
+
+        DEBUG("unique_values size: %lu, update_pat_vec size: %lu",
+              unique_codes.size(), update_pat_vec.size())
+
+        if (!updated_fp_vec.empty()) {
+          bool should_remove_column = false;
+          for (auto code : unique_codes) {
+            if (find(updated_fp_vec.begin(), updated_fp_vec.end(),
+                     values[code]) != updated_fp_vec.end()) {
+              should_remove_column = true;
+              break;
             }
           }
-
-          is_numeric_vec.push_back(is_num);
-          has_leading_zero_or_big_number_vec.push_back(
-              has_leading_zero_or_big_number);
-
-          if (length_vec.size() == 1) {
-            DEBUG("length: %lu", *length_vec.begin())
-            position_length.push_back(*length_vec.begin());
-          } else {
-            position_length.push_back(-1);
-          }
-        }
-
-        DEBUG("columns_to_remove size: %lu", columns_to_remove.size())
-        auto columns_to_keep =
-            new_missing_matrix.get_columns_to_keep(columns_to_remove);
-        DEBUG("columns_to_keep size: %lu", columns_to_keep.size())
-
-        if (!columns_to_keep.empty()) {
-          DEBUG("add to matrix_ndarray_dict")
-          // 取得matrix_ndarray的别名再进行修改
-          auto &matirx_ndarray = token_manager.matrix_ndarray_dict[dict_id];
-          matirx_ndarray.has_leading_zero_or_big_number_vec =
-              move(has_leading_zero_or_big_number_vec);
-          matirx_ndarray.is_numeric_vec = move(is_numeric_vec);
-          matirx_ndarray.position_length = move(position_length);
-          matirx_ndarray.arr = arr;
-          if (!updated_fp_vec.empty()) {
-            new_missing_matrix.set_col_index_by_swap(columns_to_keep);
+          if (should_remove_column) {
+            // new_keep_column_idx的index
+            DEBUG("should remove column: %lu", col_idx)
+            columns_to_remove.insert(col_idx);
+            continue;
           }
-          matirx_ndarray.arr_idx = move(new_missing_matrix);
         }
-      } else {
-        handle_error("No rows matched the criteria.");
-      }
-    }
 
-    if (!rows_to_delete.empty()) {
-      DEBUG("rows_to_delete size: %lu, all_rows: %lu", rows_to_delete.size(),
-            all_rows)
-      if (rows_to_delete.size() >= all_rows)
-        continue;
-
-      vector<size_t> rows_to_keep;
-      rows_to_keep.reserve(all_rows - rows_to_delete.size());
-      for (int i = 0; i < all_rows; i++) {
-        if (!rows_to_delete.contains(i))
-          rows_to_keep.push_back(i);
-      }
-
-      missing_matrix.set_row_index_by_swap(rows_to_keep);
-
-      uint64_t dict_id;
-      token_manager.get_or_register_token_no_split(mined_pat_key, 0, nullptr,
-                                                   &dict_id);
-
-      // 获得missing_matrix
-      // auto missing_matrix_for_final_pat_key =
-      // arr.get_columns(keep_column_idx);
-
-      // 取得matrix_ndarray的别名再进行修改
-      auto &matirx_ndarray = token_manager.matrix_ndarray_dict[dict_id];
-      matirx_ndarray.has_leading_zero_or_big_number_vec.reserve(
-          keep_column_idx.size());
-      matirx_ndarray.is_numeric_vec.reserve(keep_column_idx.size());
-      matirx_ndarray.position_length.reserve(keep_column_idx.size());
-      matirx_ndarray.arr = arr;
-
-      //遍历missing_matrix_for_final_pat_key的每一列，获得每一列的unique的值的个数
-      for (size_t col_idx = 0; col_idx < missing_matrix.get_col_count();
-           ++col_idx) {
         absl::flat_hash_set<size_t> length_vec;
         bool is_num = true;
         bool has_leading_zero_or_big_number = false;
-
-        IndexSet<string> unique_set;
-        for (size_t i = 0; i < missing_matrix.get_row_count(); ++i)
-          unique_set.insert(arr[missing_matrix.get(i, col_idx)]);
-        auto &unique_values = unique_set.to_vector();
-
-        for (const auto &ele : unique_values) {
+        DEBUG("for unique_values do ...")
+        for (auto code : unique_codes) {
+          const auto &ele = values[code];
           string pur_ele = ele.substr(0, ele.find('('));
-          size_t len = pur_ele.size();
-          length_vec.insert(len);
+
           if (is_num && !is_numeric(pur_ele)) {
             is_num = false;
           }
+
+          size_t len = pur_ele.size();
+          length_vec.insert(len);
+
           if (is_num && (len > 15 || (len > 1 && pur_ele[0] == '0'))) {
             has_leading_zero_or_big_number = true;
           }
         }
 
-        matirx_ndarray.is_numeric_vec.push_back(is_num);
-        matirx_ndarray.has_leading_zero_or_big_number_vec.push_back(
+        is_numeric_vec.push_back(is_num);
+        has_leading_zero_or_big_number_vec.push_back(
             has_leading_zero_or_big_number);
 
         if (length_vec.size() == 1) {
-          matirx_ndarray.position_length.push_back(*length_vec.begin());
+          DEBUG("length: %lu", *length_vec.begin())
+          position_length.push_back(*length_vec.begin());
         } else {
-          matirx_ndarray.position_length.push_back(-1);
+          position_length.push_back(-1);
         }
       }
 
-      size_t row_len = missing_matrix.get_row_count(),
-             col_len = missing_matrix.get_col_count();
-      absl::flat_hash_set<VecS> missing_matrix_hashset;
-      for (size_t j = 0; j < row_len; j++) {
-        VecS tmp_vec;
-        tmp_vec.reserve(col_len);
-        for (size_t k = 0; k < col_len; k++) {
-          tmp_vec.push_back(arr[missing_matrix.get(j, k)]);
+      DEBUG("columns_to_remove size: %lu", columns_to_remove.size())
+      auto columns_to_keep =
+          new_missing_matrix.get_columns_to_keep(columns_to_remove);
+      DEBUG("columns_to_keep size: %lu", columns_to_keep.size())
+
+      if (!columns_to_keep.empty()) {
+        DEBUG("add to matrix_ndarray_dict")
+        // 取得matrix_ndarray的别名再进行修改
+        auto &record = mined.matrices[matrix_record];
+        record.has_matrix = true;
+        auto &matirx_ndarray = record.matrix;
+        matirx_ndarray.has_leading_zero_or_big_number_vec =
+            move(has_leading_zero_or_big_number_vec);
+        matirx_ndarray.is_numeric_vec = move(is_numeric_vec);
+        matirx_ndarray.position_length = move(position_length);
+        matirx_ndarray.arr = arr;
+        if (!updated_fp_vec.empty()) {
+          new_missing_matrix.set_col_index_by_swap(columns_to_keep);
         }
-        missing_matrix_hashset.emplace(move(tmp_vec));
+        matirx_ndarray.arr_idx = move(new_missing_matrix);
       }
-      auto token_vec = update_pat_vec;
-      for (auto &token : missing_matrix_hashset) {
-        copy(token.begin(), token.end(), back_inserter(token_vec));
-        string token_str;
-        generate_rules(token_vec, token_str);
-        exp_rules_dict.emplace(move(token_str), mined_pat_key);
-        token_vec.resize(update_pat_vec.size());
+    } else {
+      handle_error("No rows matched the criteria.");
+    }
+  }
+
+  if (deleted_rows != 0) {
+    DEBUG("rows_to_delete size: %lu, all_rows: %lu", deleted_rows, all_rows)
+    if (deleted_rows >= all_rows)
+      return;
+
+    vector<size_t> rows_to_keep;
+    rows_to_keep.reserve(all_rows - deleted_rows);
+    for (size_t i = 0; i < all_rows; i++) {
+      if (!row_deleted[i])
+        rows_to_keep.push_back(i);
+    }
+
+    missing_matrix.set_row_index_by_swap(rows_to_keep);
+
+    // 获得missing_matrix
+    // auto missing_matrix_for_final_pat_key =
+    // arr.get_columns(keep_column_idx);
+
+    // 取得matrix_ndarray的别名再进行修改，合并时追加到已有的列信息之后
+    auto &matirx_ndarray =
+        mined.matrices.emplace_back(MinedPattern::MatrixRecord{
+                                        mined_pat_key, 0, true, true, {}})
+            .matrix;
+    matirx_ndarray.has_leading_zero_or_big_number_vec.reserve(
+        keep_column_idx.size());
+    matirx_ndarray.is_numeric_vec.reserve(keep_column_idx.size());
+    matirx_ndarray.position_length.reserve(keep_column_idx.size());
+    matirx_ndarray.arr = arr;
+
+    //遍历missing_matrix_for_final_pat_key的每一列，获得每一列的unique的值的个数
+    for (size_t col_idx = 0; col_idx < missing_matrix.get_col_count();
+         ++col_idx) {
+      absl::flat_hash_set<size_t> length_vec;
+      bool is_num = true;
+      bool has_leading_zero_or_big_number = false;
+
+      auto &values = arr.values(keep_column_idx[col_idx]);
+      for (auto code : arr.distinct_codes(missing_matrix, col_idx)) {
+        const auto &ele = values[code];
+        string pur_ele = ele.substr(0, ele.find('('));
+        size_t len = pur_ele.size();
+        length_vec.insert(len);
+        if (is_num && !is_numeric(pur_ele)) {
+          is_num = false;
+        }
+        if (is_num && (len > 15 || (len > 1 && pur_ele[0] == '0'))) {
+          has_leading_zero_or_big_number = true;
+        }
+      }
+
+      matirx_ndarray.is_numeric_vec.push_back(is_num);
+      matirx_ndarray.has_leading_zero_or_big_number_vec.push_back(
+          has_leading_zero_or_big_number);
+
+      if (length_vec.size() == 1) {
+        matirx_ndarray.position_length.push_back(*length_vec.begin());
+      } else {
+        matirx_ndarray.position_length.push_back(-1);
+      }
+    }
+
+    size_t row_len = missing_matrix.get_row_count(),
+           col_len = missing_matrix.get_col_count();
+    absl::flat_hash_set<vector<uint32_t>> seen_rows;
+    auto token_vec = update_pat_vec;
+    token_vec.reserve(update_pat_vec.size() + col_len);
+    for (size_t j = 0; j < row_len; j++) {
+      vector<uint32_t> row_codes;
+      row_codes.reserve(col_len);
+      for (size_t k = 0; k < col_len; k++) {
+        row_codes.push_back(arr.code(missing_matrix.get(j, k)));
       }
+      if (!seen_rows.insert(move(row_codes)).second)
+        continue;
+      for (size_t k = 0; k < col_len; k++)
+        token_vec.push_back(arr[missing_matrix.get(j, k)]);
+      string token_str;
+      generate_rules(token_vec, token_str);
+      mined.exp_rules.emplace_back(move(token_str), mined_pat_key);
+      token_vec.resize(update_pat_vec.size());
+    }
 
-      matirx_ndarray.arr_idx = move(missing_matrix);
+    matirx_ndarray.arr_idx = move(missing_matrix);
 
+  } else {
+    if (!is_unique_values_count_less_than_x)
+      handle_error(
+          "rows_to_delete is empty, shall only when unique number <= 5");
+  }
+}
+
+void LogParser::merge_mined_pattern(MinedPattern &mined) {
+  for (auto &[key, value] : mined.exp_rules) {
+    exp_rules_dict.emplace(move(key), move(value));
+  }
+  for (auto &var : mined.simple_vars) {
+    token_manager.simple_var_dict.emplace(move(var));
+  }
+  for (auto &record : mined.matrices) {
+    //注册pattern-id
+    uint64_t dict_id;
+    token_manager.get_or_register_token_no_split(record.pattern,
+                                                 record.init_flag, nullptr,
+                                                 &dict_id);
+    if (!record.has_matrix)
+      continue;
+    auto &matirx_ndarray = token_manager.matrix_ndarray_dict[dict_id];
+    auto &src = record.matrix;
+    if (record.append) {
+      auto append = [](auto &dst, auto &values) {
+        dst.insert(dst.end(), values.begin(), values.end());
+      };
+      append(matirx_ndarray.has_leading_zero_or_big_number_vec,
+             src.has_leading_zero_or_big_number_vec);
+      append(matirx_ndarray.is_numeric_vec, src.is_numeric_vec);
+      append(matirx_ndarray.position_length, src.position_length);
     } else {
-      if (!is_unique_values_count_less_than_x)
-        handle_error(
-            "rows_to_delete is empty, shall only when unique number <= 5");
+      matirx_ndarray.has_leading_zero_or_big_number_vec =
+          move(src.has_leading_zero_or_big_number_vec);
+      matirx_ndarray.is_numeric_vec = move(src.is_numeric_vec);
+      matirx_ndarray.position_length = move(src.position_length);
     }
+    matirx_ndarray.arr = src.arr;
+    matirx_ndarray.arr_idx = move(src.arr_idx);
   }
 }
 
@@ -884,31 +1036,129 @@ double LogParser::calculate_entropy(const map<string, uint32_t> &counts_map,
 
 void LogParser::process_matrix_ndarray_dict() {
   auto &matrix_ndarray_dict = token_manager.matrix_ndarray_dict.to_vector();
-  for (auto &[dict_id, matirx_ndarray] : matrix_ndarray_dict) {
-    process_single_matrix(dict_id, matirx_ndarray);
+  size_t len = matrix_ndarray_dict.size();
+  // 各矩阵并行转换为数值列并编码到内存中，最后按原顺序写入归档。
+  // 子 token 的 id 必须按矩阵顺序分配，转换时只记下待登记的值，
+  // 由当前线程统一登记并回填，之后再并行编码
+  vector<EncodedMatrix> encoded(len);
+  parallel_for(len, args.encode_matrix_threads, [&](size_t i) {
+    auto start = chr::steady_clock::now();
+    auto &[dict_id, matirx_ndarray] = matrix_ndarray_dict[i];
+    process_single_matrix(dict_id, matirx_ndarray, encoded[i]);
+    encoded[i].elapsed = chr::steady_clock::now() - start;
+  });
+
+  for (auto &matrix : encoded) {
+    for (auto &[position, value] : matrix.pending_tokens) {
+      uint64_t token_id;
+      token_manager.get_or_register_token_no_split(value, 2, nullptr,
+                                                   &token_id);
+      matrix.columns[position.first][position.second] = token_id * 2 + 1;
+    }
+  }
+
+  parallel_for(len, args.encode_matrix_threads, [&](size_t i) {
+    auto &matrix = encoded[i];
+    if (matrix.columns.empty())
+      return;
+    auto start = chr::steady_clock::now();
+    SubTokenCompressor::encode_trans_matrix_lsb(
+        matrix.data, matrix.is_delta, matrix.columns,
+        matrix.columns[0].size(), args.codec_stats ? &matrix.costs : nullptr,
+        args.python_compatible);
+    matrix.elapsed += chr::steady_clock::now() - start;
+  });
+
+  for (auto &matrix : encoded) {
+    if (!matrix.columns.empty())
+      archive.file(matrix.name) = move(matrix.data);
+    for (size_t col = 0; col < matrix.costs.size(); ++col)
+      column_costs.emplace_back(matrix.name + "[" + to_string(col) + "]",
+                                matrix.costs[col]);
+  }
+  report_matrix_encode_time(encoded);
+}
+
+// 打印本块矩阵编码的总耗时与最慢的几个矩阵，便于找出异常的矩阵
+void LogParser::report_matrix_encode_time(vector<EncodedMatrix> &encoded) {
+  if (encoded.empty())
+    return;
+  constexpr size_t SLOWEST = 3;
+  chr::duration<double, milli> total{0};
+  for (auto &matrix : encoded)
+    total += matrix.elapsed;
+  size_t shown = min(SLOWEST, encoded.size());
+  partial_sort(encoded.begin(), encoded.begin() + shown, encoded.end(),
+               [](const EncodedMatrix &a, const EncodedMatrix &b) {
+                 return a.elapsed > b.elapsed;
+               });
+
+  ostringstream oss;
+  oss << fixed << setprecision(2) << "Encoded " << encoded.size()
+      << " matrices of " << archive.path() << " in " << total.count()
+      << "ms, slowest:";
+  for (size_t i = 0; i < shown; ++i) {
+    auto &matrix = encoded[i];
+    size_t rows = matrix.columns.empty() ? 0 : matrix.columns[0].size();
+    oss << " " << matrix.name << " "
+        << chr::duration<double, milli>(matrix.elapsed).count() << "ms ("
+        << rows << "x" << matrix.columns.size() << ")";
+  }
+  // 多个块同时编码，整行一次输出避免交错
+  oss << '\n';
+  cout << oss.str() << flush;
+}
+
+// 打印本块每个数字列胜出的编码方式与各方式的估计字节数（- 为不可用），
+// 以及各方式胜出的列数
+void LogParser::report_column_codecs() {
+  size_t wins[COLUMN_CODEC_COUNT] = {};
+  ostringstream details;
+  for (auto &[name, cost] : column_costs) {
+    ++wins[size_t(cost.best)];
+    details << "  " << name << ": " << column_codec_name(cost.best) << ", "
+            << cost.values << " values,";
+    for (ColumnCodec codec : COLUMN_CODECS) {
+      size_t c = size_t(codec);
+      details << ' ' << column_codec_name(codec) << ' ';
+      if (cost.bytes[c] == SIZE_MAX)
+        details << '-';
+      else
+        details << cost.bytes[c];
+    }
+    details << " rle " << cost.rle_bytes << " bytes\n";
   }
+
+  ostringstream oss;
+  oss << "Column codecs of " << archive.path() << ":";
+  for (ColumnCodec codec : COLUMN_CODECS)
+    oss << ' ' << column_codec_name(codec) << ' ' << wins[size_t(codec)];
+  oss << '\n' << details.str();
+  // 多个块同时编码，整段一次输出避免交错
+  cout << oss.str() << flush;
 }
 
 void LogParser::process_single_matrix(uint64_t dict_id,
-                                      MatrixNdarray &matirx_ndarray) {
+                                      MatrixNdarray &matirx_ndarray,
+                                      EncodedMatrix &encoded) {
   if (should_use_delta_optimization(matirx_ndarray)) {
     DEBUG("parser.process_matrix_with_delta_optimization in")
-    process_matrix_with_delta_optimization(dict_id, matirx_ndarray);
+    process_matrix_with_delta_optimization(dict_id, matirx_ndarray, encoded);
     DEBUG("parser.process_matrix_with_delta_optimization out")
   } else {
     DEBUG("parser.process_single_matrix_original in")
-    process_single_matrix_original(dict_id, matirx_ndarray);
+    process_single_matrix_original(dict_id, matirx_ndarray, encoded);
     DEBUG("parser.process_single_matrix_original out")
   }
 }
 
 void LogParser::process_matrix_with_delta_optimization(
-    uint64_t dict_id, MatrixNdarray &matirx_ndarray) {
+    uint64_t dict_id, MatrixNdarray &matirx_ndarray, EncodedMatrix &encoded) {
   auto &arr = matirx_ndarray.arr;
   auto &arr_idx = matirx_ndarray.arr_idx;
   auto &length = matirx_ndarray.position_length;
 
-  vector<vector<uint64_t>> result_data;
+  auto &result_data = encoded.columns;
   vector<uint64_t> combined_numbers;
 
   DEBUG("Step 1: Combine columns into numbers")
@@ -928,7 +1178,7 @@ void LogParser::process_matrix_with_delta_optimization(
     if (try_stoull(combined_str, combined_num)) {
       combined_numbers.push_back(combined_num);
     } else {
-      process_single_matrix_original(dict_id, matirx_ndarray);
+      process_single_matrix_original(dict_id, matirx_ndarray, encoded);
       return;
     }
     combined_str.clear();
@@ -953,22 +1203,59 @@ void LogParser::process_matrix_with_delta_optimization(
     }
   }
 
-  // Step 3: Encode and store
-  string output_name = "delta_";
-  for (size_t i = 0; i < length.size(); ++i) {
-    output_name += to_string(length[i]);
-    output_name += "_";
+  // Step 3: 由 process_matrix_ndarray_dict 编码并写入
+  encoded.name = SubTokenCompressor::matrix_name(dict_id, true, length);
+  encoded.is_delta = true;
+}
+
+bool LogParser::encode_typed_column(MatrixNdarray &matirx_ndarray,
+                                    size_t col_idx, SubTokenType &type,
+                                    vector<vector<uint64_t>> &columns) {
+  auto &arr = matirx_ndarray.arr;
+  auto &arr_idx = matirx_ndarray.arr_idx;
+  size_t row_len = arr_idx.get_row_count();
+  auto &values = arr.values(arr_idx.get(0, col_idx).col_idx);
+  auto pure = [&](uint32_t code) {
+    auto &ele = values[code];
+    return string_view(ele).substr(0, ele.find('('));
+  };
+
+  // 只检查本矩阵的行用到的值
+  vector<uint8_t> used(values.size(), 0);
+  SubTokenTypeDetector detector;
+  for (size_t row_idx = 0; row_idx < row_len; ++row_idx) {
+    uint32_t code = arr.code(arr_idx.get(row_idx, col_idx));
+    if (!used[code]) {
+      used[code] = 1;
+      detector.add(pure(code));
+    }
+  }
+  type = detector.type();
+  if (type == SubTokenType::TAGGED)
+    return false;
+
+  size_t slots = sub_token_slots(type, detector.width());
+  size_t first = columns.size();
+  columns.resize(first + slots);
+  for (size_t s = 0; s < slots; ++s)
+    columns[first + s].reserve(row_len);
+  // 每个不同的值只解析一次
+  vector<uint64_t> parsed(values.size() * slots);
+  for (uint32_t code = 0; code < values.size(); ++code) {
+    if (used[code])
+      parse_sub_token(pure(code), type, &parsed[code * slots]);
+  }
+  for (size_t row_idx = 0; row_idx < row_len; ++row_idx) {
+    uint32_t code = arr.code(arr_idx.get(row_idx, col_idx));
+    for (size_t s = 0; s < slots; ++s)
+      columns[first + s].push_back(parsed[code * slots + s]);
   }
-  output_name.pop_back();
-  DEBUG("SubTokenCompressor::encode_and_store_trans_matrix_lsb in")
-  SubTokenCompressor::encode_and_store_trans_matrix_lsb(
-      output_dir, "_" + to_string(dict_id) + "_" + output_name, result_data,
-      result_data[0].size());
-  DEBUG("SubTokenCompressor::encode_and_store_trans_matrix_lsb out")
+  return true;
 }
 
 void LogParser::process_single_matrix_original(uint64_t dict_id,
-                                               MatrixNdarray &matirx_ndarray) {
+                                               MatrixNdarray &matirx_ndarray,
+                                               EncodedMatrix &encoded) {
 
   auto &arr = matirx_ndarray.arr;
   auto &arr_idx = matirx_ndarray.arr_idx;
@@ -978,7 +1265,8 @@ void LogParser::process_single_matrix_original(uint64_t dict_id,
       matirx_ndarray.has_leading_zero_or_big_number_vec;
   size_t col_len = arr_idx.get_col_count(), row_len = arr_idx.get_row_count();
 
-  vector<vector<uint64_t>> result_data;
+  auto &result_data = encoded.columns;
+  vector<SubTokenType> types(col_len, SubTokenType::TAGGED);
   DEBUG("for each column ... col_len=%lu, row_len=%lu", col_len, row_len)
   for (size_t col_idx = 0; col_idx < col_len; ++col_idx) {
     DEBUG("loop - col_idx=%lu", col_idx)
@@ -986,58 +1274,54 @@ void LogParser::process_single_matrix_original(uint64_t dict_id,
     bool column_is_numeric = is_numeric_vec[col_idx];
     bool column_has_leading_zero_or_big_number =
         has_leading_zero_or_big_number[col_idx];
+    if (!args.python_compatible &&
+        encode_typed_column(matirx_ndarray, col_idx, types[col_idx],
+                            result_data))
+      continue;
 
+    size_t storage_idx = result_data.size();
     auto &column_data = result_data.emplace_back();
     column_data.reserve(row_len);
 
-    if (column_is_numeric &&
-        (column_length > 0 || !column_has_leading_zero_or_big_number)) {
-      for (size_t row_idx = 0; row_idx < row_len; ++row_idx) {
-        auto &ele = arr[arr_idx.get(row_idx, col_idx)];
+    // 每个不同的值只解析一次：NUMBER 为编码后的数值，TOKEN 需登记为子 token
+    enum : uint8_t { UNPARSED, NUMBER, TOKEN };
+    auto &values = arr.values(arr_idx.get(0, col_idx).col_idx);
+    vector<uint8_t> kind(values.size(), UNPARSED);
+    vector<uint64_t> number(values.size(), 0);
+    bool all_numeric =
+        column_is_numeric &&
+        (column_length > 0 || !column_has_leading_zero_or_big_number);
+
+    for (size_t row_idx = 0; row_idx < row_len; ++row_idx) {
+      uint32_t code = arr.code(arr_idx.get(row_idx, col_idx));
+      auto &ele = values[code];
+      if (kind[code] == UNPARSED) {
         string value = ele.substr(0, ele.find('('));
-
-        uint64_t parsed_value;
-        if (try_stoull(value, parsed_value))
-          column_data.push_back(parsed_value * 2);
-        else
-          column_data.push_back(0);
-      }
-    } else {
-      for (size_t row_idx = 0; row_idx < row_len; ++row_idx) {
-        auto &ele = arr[arr_idx.get(row_idx, col_idx)];
-        string value = ele.substr(0, ele.find('('));
-
-        if (is_numeric(value) && value.length() <= 15 &&
-            (value.length() == 1 || value[0] != '0')) {
+        if (all_numeric ||
+            (is_numeric(value) && value.length() <= 15 &&
+             (value.length() == 1 || value[0] != '0'))) {
           uint64_t parsed_value;
           if (try_stoull(value, parsed_value))
-            column_data.push_back(parsed_value * 2);
-          else
-            column_data.push_back(0);
+            number[code] = parsed_value * 2;
+          kind[code] = NUMBER;
         } else {
-          uint64_t token_id;
-          token_manager.get_or_register_token_no_split(value, 2, nullptr,
-                                                       &token_id);
-          column_data.push_back(token_id * 2 + 1);
+          kind[code] = TOKEN;
         }
       }
+      if (kind[code] == TOKEN) {
+        // id 稍后按顺序登记后回填
+        encoded.pending_tokens.emplace_back(
+            make_pair(storage_idx, column_data.size()),
+            ele.substr(0, ele.find('(')));
+      }
+      column_data.push_back(number[code]);
     }
   }
 
-  if (result_data.empty())
-    return;
-  DEBUG("Store Result")
-  // 存储结果
-  string output_name;
-  for (size_t i = 0; i < length.size(); ++i) {
-    output_name += to_string(length[i]);
-    output_name += "_";
-  }
-  output_name.pop_back();
-
-  SubTokenCompressor::encode_and_store_trans_matrix_lsb(
-      output_dir, "_" + to_string(dict_id) + "_" + output_name, result_data,
-      result_data[0].size());
+  // 由 process_matrix_ndarray_dict 编码并写入
+  encoded.name =
+      SubTokenCompressor::matrix_name(dict_id, false, length, types);
+  encoded.is_delta = false;
 }
 
 void LogParser::export_chunk_subtoken_dictionary() {
@@ -1045,7 +1329,6 @@ void LogParser::export_chunk_subtoken_dictionary() {
   if (subtoken_dict.empty())
     return;
 
-  string dictionary_path = output_dir + "/token.txt";
 
   // 1. 收集并排序
   auto sorted_entries = vector<pair<uint64_t, string>>(subtoken_dict.begin(),
@@ -1055,29 +1338,18 @@ void LogParser::export_chunk_subtoken_dictionary() {
        [](const pair<uint64_t, string> &a, const pair<uint64_t, string> &b) {
          return a.first < b.first;
        });
-  ofstream file(dictionary_path);
-  if (!file.is_open()) {
-    handle_error(
-        format("Failed to create output file: %s", dictionary_path.c_str()));
-  }
+  auto &file = archive.file(TOKEN_DICT_STREAM);
   // 2. 逐行写入纯token
   for (auto &[_, token] : sorted_entries) {
-    file << token << "\n";
+    file += token;
+    file += '\n';
   }
-  file.flush();
-  file.close();
   cout << "Successfully exported " << sorted_entries.size() << " tokens to "
-       << dictionary_path << endl;
+       << archive.path() << "/" << TOKEN_DICT_STREAM << endl;
 }
 
 void LogParser::export_unmapped_templates_with_dict_id_for_chunk() {
-  string output_path = output_dir + "/template.txt";
-
-  ofstream file(output_path);
-  if (!file.is_open()) {
-    handle_error(
-        format("Failed to create output file: %s", output_path.c_str()));
-  }
+  auto &file = archive.file(TEMPLATE_DICT_STREAM);
 
   auto entries =
       vector<pair<uint32_t, string>>(unmapped_templates_with_dict_id.begin(),
@@ -1090,8 +1362,7 @@ void LogParser::export_unmapped_templates_with_dict_id_for_chunk() {
 
   for (auto &[i, template_str] : entries) {
     DEBUG("i=%u, template_str=%s", i, template_str.c_str())
-    file << template_str << "\n";
+    file += template_str;
+    file += '\n';
   }
-  file.flush();
-  file.close();
 }
\ No newline at end of file
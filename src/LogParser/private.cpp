@@ -8,30 +8,30 @@
 using namespace std;
 
 void LogParser::add_to_exp_rules_dict(
-    const absl::flat_hash_set<VecS> &sole_pat_set, const string &value) {
+    const absl::flat_hash_set<VecS> &sole_pat_set, const string &value,
+    MinedPattern &mined) {
   for (const auto &tokens : sole_pat_set) {
     string token_str;
     generate_rules(tokens, token_str);
-    exp_rules_dict.emplace(move(token_str), value);
+    mined.exp_rules.emplace_back(move(token_str), value);
   }
 }
 
 void LogParser::add_to_matrix_ndarray_dict(
     const VecS &update_pat_vec, const absl::flat_hash_set<VecS> &sole_pat_set,
     const vector<size_t> &keep_column_idx, const string &final_pat_key,
-    Array2<string> &arr) {
-
-  //注册pattern-id
-  uint64_t dict_id;
-  token_manager.get_or_register_token_no_split(final_pat_key, 1, nullptr,
-                                               &dict_id);
+    Array2<string> &arr, MinedPattern &mined) {
 
   // 获得missing_matrix
   // auto missing_matrix_for_final_pat_key =
   // arr.get_columns(keep_column_idx);
 
-  // 取得matrix_ndarray的别名再进行修改
-  auto &matirx_ndarray = token_manager.matrix_ndarray_dict[dict_id];
+  // pattern-id 在合并时注册，列信息追加到已有的 matrix_ndarray 之后
+  auto &matirx_ndarray =
+      mined.matrices
+          .emplace_back(
+              MinedPattern::MatrixRecord{final_pat_key, 1, true, true, {}})
+          .matrix;
   matirx_ndarray.has_leading_zero_or_big_number_vec.reserve(
       keep_column_idx.size());
   matirx_ndarray.is_numeric_vec.reserve(keep_column_idx.size());
@@ -45,13 +45,8 @@ void LogParser::add_to_matrix_ndarray_dict(
     bool is_num = true;
     bool has_leading_zero_or_big_number = false;
 
-    auto column_index = arr.get_column(keep_column_idx[col_idx]);
-    IndexSet<string> unique_set;
-    for (size_t i = 0; i < column_index.size(); ++i)
-      unique_set.insert(arr[column_index.get(i)]);
-    auto &unique_values = unique_set.to_vector();
-
-    for (const auto &ele : unique_values) {
+    // 整列出现过的值即该列的值表
+    for (const auto &ele : arr.values(keep_column_idx[col_idx])) {
       string pur_ele = ele.substr(0, ele.find('('));
 
       if (is_num && !is_numeric(pur_ele))
@@ -118,12 +113,16 @@ bool LogParser::should_use_delta_optimization(MatrixNdarray &matirx_ndarray) {
     return false;
   }
 
-  size_t sample_size = min<size_t>(10, row_len);
+  // 在整个矩阵上等距取至多 10 对相邻行，而不只看开头几行；
+  // delta 编码写出的正是相邻行之差
+  size_t pair_count = min<size_t>(10, row_len - 1);
+  size_t stride = (row_len - 1) / pair_count;
   vector<uint64_t> sample_numbers;
-  sample_numbers.reserve(sample_size);
+  sample_numbers.reserve(pair_count * 2);
 
   string combined_str;
-  for (size_t row_idx = 0; row_idx < sample_size; ++row_idx) {
+  for (size_t k = 0; k < pair_count * 2; ++k) {
+    size_t row_idx = k / 2 * stride + k % 2;
     // auto row = matrix.row(row_idx);
     for (size_t col_idx = 0; col_idx < col_len; ++col_idx) {
       auto &ele = arr[arr_idx.get(row_idx, col_idx)];
@@ -156,8 +155,8 @@ bool LogParser::is_suitable_for_delta_encoding(
   }
 
   vector<uint64_t> deltas;
-  deltas.reserve(numbers.size());
-  for (size_t i = 1; i < numbers.size(); ++i) {
+  deltas.reserve(numbers.size() / 2);
+  for (size_t i = 1; i < numbers.size(); i += 2) {
     if (numbers[i] >= numbers[i - 1]) {
       deltas.push_back(numbers[i] - numbers[i - 1]);
     } else {
@@ -1,70 +1,87 @@
 #include "LogParser.hpp"
 #include "TokenManager.hpp"
 #include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
 #include "arg.hpp"
 #include "internal/out.hpp"
 #include "utils/util.hpp"
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
-#include <filesystem>
 #include <iostream>
 #include <processor.hpp>
 #include <string>
+#include <string_view>
 #include <vector>
 // using namespace std::chrono;
 namespace chr = std::chrono;
-namespace fs = std::filesystem;
-void process_log_chunk(const VecS &logs, const IndexManager &im,
-                       size_t chunk_idx, const Args args) {
-  LogParser parser(args);
-  auto start_time = chr::steady_clock::now();
-  std::cout << "Processing chunk " << chunk_idx << " (" << im.len()
+void parse_log_chunk(ChunkTask &task, const Args &args) {
+  task.parser = std::make_unique<LogParser>(args);
+  auto &parser = *task.parser;
+  auto chunk_idx = task.chunk.chunk_idx;
+  task.start_time = chr::steady_clock::now();
+  task.line_count = task.chunk.lines.size();
+  task.stream_vbyte = args.stream_vbyte;
+  std::cout << "Processing chunk " << chunk_idx << " (" << task.line_count
             << " lines)..." << std::endl;
-  // 更新输出目录
-  auto output_dir = args.output_dir;
-  output_dir = output_dir + "/" + std::to_string(chunk_idx);
-  fs::create_directories(output_dir);
-  parser.update_output_dir(output_dir);
-  DEBUG("parser.process_chunk: in")
-  parser.process_chunk(logs, im, chunk_idx);
-  DEBUG("parser.process_chunk: out")
+  // 块的输出直接写入 <output_dir>/<idx>.tar.xz，不再创建中间目录
+  parser.update_output_path(args.output_dir + "/" + std::to_string(chunk_idx));
+  IndexManager im(task.chunk.first_line, task.line_count);
+  DEBUG("parser.parse_chunk: in")
+  parser.parse_chunk(task.chunk.lines, im);
+  DEBUG("parser.parse_chunk: out")
+}
+
+void mine_log_chunk(ChunkTask &task) {
+  DEBUG("pasrser.process_patterns_exp: in")
+  task.parser->process_patterns_exp();
+  DEBUG("pasrser.process_patterns_exp: out")
+}
+
+void encode_log_chunk(ChunkTask &task) {
+  auto &parser = *task.parser;
+  auto chunk_idx = task.chunk.chunk_idx;
+  parser.encode_chunk();
 
   //////////////// ORIGINAL 0710 ////////////////
 
   // 使用从0开始的新计数器生成template IDs
   std::vector<uint32_t> new_tmpl_ids;
   uint32_t new_id_counter = 0;
+  uint32_t shared_size = task.shared ? uint32_t(task.shared->size()) : 0;
   // 创建模板到ID的映射，用于快速查找
   absl::flat_hash_map<std::string, uint32_t> tmpl_id_map;
   std::vector<uint64_t> dynamic_entries; // 预测性分配内存
-  dynamic_entries.reserve(parser.runtime_space.size() *
-                          parser.runtime_space[0].first.size() / 2);
+  dynamic_entries.reserve(parser.runtime_space.var_count() / 2);
 
   std::vector<int32_t> tmpl_replacements;
   // 预测性分配内存 && 用完要clear防止反复分配内存
-  tmpl_replacements.reserve(parser.runtime_space[0].first.size());
+  tmpl_replacements.reserve(16);
+  // 需要登记的变量复制到这里，复用同一块内存
+  std::string var_buf;
 
   for (uint32_t raw_id = 0; raw_id < parser.runtime_space.size(); raw_id++) {
-    auto &runtime_entry = parser.runtime_space[raw_id];
-    auto parsed_id = runtime_entry.second;
+    auto parsed_id = parser.runtime_space.template_id(raw_id);
     const auto &original_tmpl = parser.parsed_log_map[parsed_id];
 
     // std::vector<uint64_t> tmpl_replacements; // Delete
     tmpl_replacements.clear();
 
     // if (!runtime_entry.empty()) {
-    for (auto &var : runtime_entry.first) {
+    for (std::string_view var : parser.runtime_space.line(raw_id)) {
       uint64_t entry = 0;
-      auto rule = parser.exp_rules_dict.find(var);
-      DEBUG("var: %s, rule: %s", var.empty() ? "nullptr" : var.c_str(),
+      // 以 absl::string_view 异构查找，不构造 std::string
+      auto rule =
+          parser.exp_rules_dict.find(absl::string_view(var.data(), var.size()));
+      DEBUG("var: %s, rule: %s", std::string(var).c_str(),
             rule == parser.exp_rules_dict.end() ? "nullptr"
                                                 : rule->second.c_str())
       if (rule == parser.exp_rules_dict.end() || rule->second.empty()) {
         if (!is_numeric(var) || var.length() > 15) {
           // init_flag 只有 -1 和其它有区别
-          parser.token_manager.get_or_register_token_no_split(var, 1, nullptr,
-                                                              &entry);
+          var_buf.assign(var);
+          parser.token_manager.get_or_register_token_no_split(
+              var_buf, 1, nullptr, &entry);
           dynamic_entries.push_back(entry);
         }
       } else {
@@ -100,19 +117,30 @@ void process_log_chunk(const VecS &logs, const IndexManager &im,
     //   continue;
     // }
 
+    // 共享字典中已有的模板直接引用，块内的 id 排在共享字典之后
+    uint32_t shared_id;
+    if (task.shared && task.shared->find(tmpl_to_use, shared_id)) {
+      new_tmpl_ids.push_back(shared_id);
+      continue;
+    }
     auto iter = tmpl_id_map.find(tmpl_to_use);
     auto tmpl_id = iter == tmpl_id_map.end() ? new_id_counter++ : iter->second;
 
     parser.unmapped_templates_with_dict_id.emplace(tmpl_id, tmpl_to_use);
     tmpl_id_map.emplace(tmpl_to_use, tmpl_id);
-    new_tmpl_ids.push_back(tmpl_id);
+    new_tmpl_ids.push_back(shared_size + tmpl_id);
   }
 
-  SubTokenCompressor::encode_and_store_template_id(output_dir, "templateid",
-                                                   new_tmpl_ids);
+  if (task.stream_vbyte)
+    SubTokenCompressor::encode_and_store_template_id_svb(
+        parser.archive, TEMPLATE_ID_SVB_STREAM, new_tmpl_ids);
+  else
+    SubTokenCompressor::encode_and_store_template_id(
+        parser.archive, TEMPLATE_ID_STREAM, new_tmpl_ids);
 
   auto end_time = chr::steady_clock::now();
-  auto elasped = chr::duration_cast<chr::milliseconds>(end_time - start_time);
+  auto elasped =
+      chr::duration_cast<chr::milliseconds>(end_time - task.start_time);
   std::cout << "Processed chunk " << chunk_idx << " in " << elasped.count()
             << "ms." << std::endl;
 
@@ -120,8 +148,34 @@ void process_log_chunk(const VecS &logs, const IndexManager &im,
 
   parser.export_unmapped_templates_with_dict_id_for_chunk();
 
-  std::vector<uint8_t> buffer;
-  SubTokenCompressor::batch_encode_dynamic(dynamic_entries, buffer);
+  // id 超过 32 位时 Stream VByte 无法表示，退回 LEB128
+  if (task.stream_vbyte &&
+      SubTokenCompressor::batch_encode_dynamic_svb(dynamic_entries,
+                                                   task.dynamic_buffer)) {
+    task.token_id_stream = TOKEN_ID_SVB_STREAM;
+  } else {
+    SubTokenCompressor::batch_encode_dynamic(dynamic_entries,
+                                             task.dynamic_buffer);
+    task.token_id_stream = TOKEN_ID_STREAM;
+  }
+  // 解析器的状态到此为止不再需要，提前释放
+  task.archive = std::move(parser.archive);
+  task.parser.reset();
+}
 
-  SubTokenCompressor::compress_chunk(buffer, output_dir);
+void archive_log_chunk(ChunkTask &task, const Args &args,
+                       ContainerWriter *container) {
+  if (container) {
+    task.archive.file(task.token_id_stream)
+        .assign(reinterpret_cast<const char *>(task.dynamic_buffer.data()),
+                task.dynamic_buffer.size());
+    container->append(task.chunk.chunk_idx, task.chunk.first_line,
+                      task.line_count, task.archive);
+  } else {
+    SubTokenCompressor::compress_chunk(
+        task.dynamic_buffer, task.token_id_stream, task.archive, args.codec);
+  }
+  task.dynamic_buffer.clear();
+  task.dynamic_buffer.shrink_to_fit();
+  task.archive = ChunkArchive();
 }
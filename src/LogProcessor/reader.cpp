@@ -0,0 +1,116 @@
+#include <ChunkReader.hpp>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utils/util.hpp>
+
+static constexpr size_t READ_BLOCK_SIZE = 1 << 20;
+
+ChunkReader::ChunkReader(const std::string &filename, size_t chunk_size)
+    : chunk_size(chunk_size) {
+  if (filename == "-") {
+    fd = STDIN_FILENO;
+    is_stream = true;
+    return;
+  }
+
+  struct stat st;
+  if (stat(filename.c_str(), &st) != 0)
+    handle_error("Cannot open file: " + filename);
+  if (S_ISREG(st.st_mode)) {
+    file.open(filename);
+    return;
+  }
+
+  // FIFO / 进程替换 <(cmd) 等只能顺序读取
+  fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    handle_error("Cannot open file: " + filename);
+  is_stream = true;
+}
+
+ChunkReader::~ChunkReader() {
+  if (fd > STDIN_FILENO)
+    ::close(fd);
+}
+
+bool ChunkReader::next(LogChunk &chunk) {
+  bool ok = is_stream ? next_stream(chunk) : next_mapped(chunk);
+  if (ok) {
+    chunk.chunk_idx = next_chunk_idx++;
+    chunk.first_line = next_line;
+    next_line += chunk.lines.size();
+  }
+  return ok;
+}
+
+bool ChunkReader::next_mapped(LogChunk &chunk) {
+  if (pos >= file.size())
+    return false;
+
+  chunk.offset = pos;
+  chunk.length =
+      chunk.lines.assign(file.data() + pos, file.size() - pos, chunk_size);
+  pos += chunk.length;
+  return true;
+}
+
+bool ChunkReader::next_stream(LogChunk &chunk) {
+  auto &buf = chunk.storage;
+  buf.clear();
+  buf.swap(carry);
+
+  // 统计已到达的完整行，凑够 chunk_size 行立即切块，不等待后续输入
+  size_t scanned = 0, line_count = 0, cut = 0;
+  while (true) {
+    while (line_count < chunk_size && scanned < buf.size()) {
+      auto nl = static_cast<const char *>(
+          std::memchr(buf.data() + scanned, '\n', buf.size() - scanned));
+      if (!nl) {
+        scanned = buf.size();
+        break;
+      }
+      scanned = size_t(nl - buf.data()) + 1;
+      cut = scanned;
+      ++line_count;
+    }
+    if (line_count >= chunk_size || eof)
+      break;
+
+    // 直接 resize 会在每次 read 前把 1 MiB 清零，先读入暂存区再追加，
+    // storage 的容量由 insert 按倍数增长
+    if (block.empty())
+      block.resize(READ_BLOCK_SIZE);
+    ssize_t n = read(fd, block.data(), block.size());
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0)
+      handle_error(std::string("Read from input failed: ") + strerror(errno));
+    else if (n == 0)
+      eof = true;
+    else
+      buf.insert(buf.end(), block.data(), block.data() + n);
+  }
+
+  // 输入结束时剩余内容（可能没有换行符）整体作为最后一块
+  if (eof && line_count < chunk_size)
+    cut = buf.size();
+  if (cut == 0)
+    return false;
+
+  carry.assign(buf.begin() + cut, buf.end());
+  buf.resize(cut);
+  chunk.offset = 0;
+  chunk.length = cut;
+  chunk.lines.assign(buf.data(), buf.size(), chunk_size);
+  return true;
+}
+
+void ChunkReader::release(const LogChunk &chunk) const {
+  if (!is_stream)
+    file.release(chunk.offset, chunk.length);
+}
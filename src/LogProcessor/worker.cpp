@@ -1,13 +1,18 @@
+#include "ChunkReader.hpp"
+#include "LogDecoder.hpp"
+#include "SharedTemplates.hpp"
 #include "internal/out.hpp"
+#include "utils/BoundedQueue.hpp"
+#include "utils/StagePool.hpp"
 #include "utils/util.hpp"
 #include <arg.hpp>
 #include <atomic>
 #include <chrono>
 #include <cstddef>
 #include <filesystem>
-#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <processor.hpp>
 #include <thread>
@@ -23,73 +28,106 @@ void columnar_subtoken_compress_logs(const Args &args) {
 
   // 递归创建目录
   fs::create_directories(args.output_dir);
+  cout << "Backend codec: " << codec_name(args.codec) << endl;
 
-  // 读取日志文件
-  VecS logs;
-  read_benchmark_file(logs, args.input_file);
+  // 边读边分块，块依次经过 解析 -> 挖掘 -> 编码 -> 打包压缩 四个阶段，
+  // 每个阶段有独立的线程池，阶段之间用有界队列连接。
+  // 这样第 N 块的 xz 压缩可以和第 N+1 块的解析同时进行
+  ChunkReader reader(args.input_file, args.chunk_size);
+  BoundedQueue<ChunkTask> parse_queue(args.parse_threads),
+      mine_queue(args.mine_threads), encode_queue(args.encode_threads),
+      archive_queue(args.archive_threads);
 
-  // 生成分块信息 (chunk_idx, start, end)
-  vector<tuple<size_t, size_t, size_t>> chunks;
-  for (size_t start = 0, chunk_idx = 0; start < logs.size();
-       start += args.chunk_size, ++chunk_idx) {
-    size_t end = min(start + args.chunk_size, logs.size());
-    chunks.emplace_back(chunk_idx, start, end);
+  StagePool<ChunkTask> parse_pool("Parse", args.parse_threads),
+      mine_pool("Mine", args.mine_threads),
+      encode_pool("Encode", args.encode_threads),
+      archive_pool("Archive", args.archive_threads);
 
-    // 打印分块信息
-    cout << "Chunk " << chunk_idx << ": lines " << start << " - " << end
-         << endl;
-  }
-  // num_threads * chunk_per_thread >= chunks.size()
-  auto chunks_per_thread = chunks.size() / args.num_threads;
-  // cout << "Chunks per thread: " << chunks_per_thread << endl;
-  while (args.num_threads * chunks_per_thread < chunks.size())
-    ++chunks_per_thread;
-  cout << "Chunks per thread: " << chunks_per_thread << endl;
-  vector<pair<size_t, size_t>> ranges;
-  for (size_t start = 0; start < chunks.size(); start += chunks_per_thread) {
-    size_t end = min(start + chunks_per_thread, chunks.size());
-    ranges.emplace_back(start, end);
-    cout << "Thread " << ranges.size() - 1 << ": chunks " << start << " - "
-         << end << endl;
+  auto parse_stage = [&reader, &args](ChunkTask &t) {
+    DEBUG("parse_log_chunk: in")
+    parse_log_chunk(t, args);
+    DEBUG("parse_log_chunk: out")
+    // 解析完成后行内容不再需要
+    reader.release(t.chunk);
+    t.chunk.storage = {};
+    t.chunk.lines = {};
+  };
+  parse_pool.start(parse_queue, &mine_queue, parse_stage);
+  mine_pool.start(mine_queue, &encode_queue, mine_log_chunk);
+  encode_pool.start(encode_queue, &archive_queue, encode_log_chunk);
+  std::unique_ptr<ContainerWriter> container;
+  if (args.container) {
+    container = std::make_unique<ContainerWriter>(
+        args.output_dir + "/" + CONTAINER_FILE_NAME, args.codec);
   }
+  archive_pool.start(archive_queue, nullptr,
+                     [&args, c = container.get()](ChunkTask &t) {
+                       archive_log_chunk(t, args, c);
+                     });
 
-  vector<thread> workers;
+  // 共享模板字典随输出一起写出，解压时先于各块载入
+  SharedTemplates shared;
+  auto write_shared = [&]() {
+    ChunkArchive archive(args.output_dir + "/" + SHARED_ARCHIVE_NAME);
+    archive.file(SHARED_TEMPLATE_STREAM) = shared.serialize();
+    if (container)
+      container->set_shared(archive);
+    else
+      archive.write(args.codec);
+    cout << "Shared templates: " << shared.size() << endl;
+  };
+  bool warm_up = false;
+  if (!args.template_dict.empty()) {
+    shared.load(read_shared_templates(args.template_dict));
+    write_shared();
+  } else {
+    warm_up = args.shared_templates;
+  }
 
-  for (size_t i = 0; i < args.num_threads && i < ranges.size(); ++i) {
-    // auto output_dir = args.output_dir;
-    workers.emplace_back([&logs, &args, &chunks, &ranges, i] {
-      for (size_t j = ranges[i].first; j < ranges[i].second; ++j) {
-        auto &[cidx, st, ed] = chunks[j];
-        // 获取下标管理器
-        IndexManager im(st, ed - st);
-        // 处理块
-        DEBUG("process_log_chunk: in")
-        process_log_chunk(logs, im, cidx, args);
-        DEBUG("process_log_chunk: out")
+  ChunkTask task;
+  while (reader.next(task.chunk)) {
+    // 打印分块信息
+    auto &chunk = task.chunk;
+    cout << "Chunk " << chunk.chunk_idx << ": lines " << chunk.first_line
+         << " - " << chunk.first_line + chunk.lines.size() << endl;
+    if (warm_up) {
+      // 第一块在当前线程上先完成解析、挖掘与编码，它的模板即为共享字典。
+      // 其 id 与共享字典中的位置一一对应，块内的 template.txt 置空
+      warm_up = false;
+      parse_stage(task);
+      mine_log_chunk(task);
+      encode_log_chunk(task);
+      for (auto &[name, data] : task.archive.entries()) {
+        if (name == TEMPLATE_DICT_STREAM) {
+          shared.load(data);
+          data.clear();
+        }
       }
-    });
+      write_shared();
+      archive_queue.push(move(task));
+    } else {
+      task.shared = args.shared_templates ? &shared : nullptr;
+      parse_queue.push(move(task));
+    }
+    task = ChunkTask();
   }
+  parse_queue.close();
 
-  // 等待所有工作线程完成
-  for (auto &worker : workers) {
-    if (worker.joinable())
-      worker.join();
-  }
+  // 等待所有阶段完成
+  parse_pool.join();
+  mine_pool.join();
+  encode_pool.join();
+  archive_pool.join();
+  if (container)
+    container->finish();
+
+  parse_pool.report();
+  mine_pool.report();
+  encode_pool.report();
+  archive_pool.report();
 
   // 打印耗时
   auto elapsed = chr::duration_cast<chr::milliseconds>(
       chr::steady_clock::now() - start_time);
   cout << "Total Processing time taken: " << elapsed.count() << "ms\n";
 }
-
-// 示例辅助函数实现 (需根据实际需求完善)
-void read_benchmark_file(VecS &lines, const string &filename) {
-  ifstream file(filename);
-  if (!file)
-    handle_error("Cannot open file: " + filename);
-
-  string line;
-  while (getline(file, line)) {
-    lines.emplace_back(move(line));
-  }
-}
@@ -0,0 +1,297 @@
+#include "ColumnCodec.hpp"
+#include "TokenManager.hpp"
+#include "absl/container/flat_hash_map.h"
+#include "utils/BitPacking.hpp"
+#include "utils/util.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+const char *column_codec_name(ColumnCodec codec) {
+  switch (codec) {
+  case ColumnCodec::RAW:
+    return "raw";
+  case ColumnCodec::DELTA:
+    return "delta";
+  case ColumnCodec::FOR:
+    return "for";
+  case ColumnCodec::DELTA_OF_DELTA:
+    return "dod";
+  case ColumnCodec::DICT:
+    return "dict";
+  }
+  return "unknown";
+}
+
+static size_t unsigned_leb128_size(uint64_t value) {
+  size_t size = 1;
+  while (value >>= 7)
+    ++size;
+  return size;
+}
+
+static size_t signed_leb128_size(int64_t value) {
+  size_t size = 1;
+  while (value >= 64 || value < -64) {
+    value >>= 7;
+    ++size;
+  }
+  return size;
+}
+
+static void put_unsigned(std::string &out, uint64_t value) {
+  do {
+    uint8_t byte = value & 0x7F;
+    value >>= 7;
+    out.push_back(char(value ? byte | 0x80 : byte));
+  } while (value);
+}
+
+static void put_signed(std::string &out, int64_t value) {
+  bool more;
+  do {
+    uint8_t byte = value & 0x7F;
+    value >>= 7;
+    more = !((value == 0 && (byte & 0x40) == 0) ||
+             (value == -1 && (byte & 0x40) != 0));
+    out.push_back(char(more ? byte | 0x80 : byte));
+  } while (more);
+}
+
+// 相邻差值的差：首个值为原值，第二个为差值，之后为差值之差。
+// 以无符号运算回绕，解码时同样回绕即可还原
+struct DeltaOfDelta {
+  uint64_t prev = 0, prev_delta = 0;
+  bool first = true;
+
+  int64_t next(uint64_t value) {
+    uint64_t delta = value - prev;
+    int64_t dod = int64_t(delta - prev_delta);
+    prev = value;
+    prev_delta = first ? 0 : delta;
+    first = false;
+    return dod;
+  }
+  uint64_t undo(int64_t dod) {
+    uint64_t delta = uint64_t(dod) + prev_delta;
+    prev += delta;
+    prev_delta = first ? 0 : delta;
+    first = false;
+    return prev;
+  }
+};
+
+// 按出现次数降序（相同时按值升序）编号，出现多的值序号短。
+// 不同值超过 limit 个时返回 false
+static bool build_dict(const std::vector<uint64_t> &values, size_t limit,
+                       std::vector<std::pair<uint64_t, size_t>> &dict,
+                       absl::flat_hash_map<uint64_t, uint32_t> &codes) {
+  absl::flat_hash_map<uint64_t, size_t> counts;
+  for (uint64_t v : values) {
+    if (++counts[v] == 1 && counts.size() > limit)
+      return false;
+  }
+  dict.assign(counts.begin(), counts.end());
+  std::sort(dict.begin(), dict.end(), [](const auto &a, const auto &b) {
+    return a.second != b.second ? a.second > b.second : a.first < b.first;
+  });
+  codes.reserve(dict.size());
+  for (size_t i = 0; i < dict.size(); ++i)
+    codes.emplace(dict[i].first, uint32_t(i));
+  return true;
+}
+
+ColumnCost estimate_column(const std::vector<uint64_t> &values,
+                           bool standalone, bool legacy) {
+  ColumnCost cost;
+  size_t n = cost.values = values.size();
+  // 标记，以及新编码方式在独立数字流中写出的值的个数
+  size_t head = 1 + (standalone ? unsigned_leb128_size(n) : 0);
+
+  size_t raw = 0, delta = 0, dod = 0, rle = 0, run = 0;
+  // 差值按无符号计算后再转为有符号，与 DeltaOfDelta 相同，不会溢出
+  uint64_t prev = 0, run_value = 0;
+  DeltaOfDelta dod_state;
+  for (uint64_t v : values) {
+    raw += standalone ? signed_leb128_size(int64_t(v))
+                      : unsigned_leb128_size(v);
+    delta += signed_leb128_size(int64_t(v - prev));
+    prev = v;
+    dod += signed_leb128_size(dod_state.next(v));
+    if (run > 0 && v == run_value) {
+      ++run;
+      continue;
+    }
+    if (run > 0)
+      rle += unsigned_leb128_size(run_value) + unsigned_leb128_size(run);
+    run_value = v;
+    run = 1;
+  }
+  if (run > 0)
+    rle += unsigned_leb128_size(run_value) + unsigned_leb128_size(run);
+
+  auto &bytes = cost.bytes;
+  std::fill(std::begin(bytes), std::end(bytes), SIZE_MAX);
+  bytes[size_t(ColumnCodec::RAW)] = 1 + raw;
+  bytes[size_t(ColumnCodec::DELTA)] = 1 + delta;
+  bytes[size_t(ColumnCodec::DELTA_OF_DELTA)] = head + dod;
+  cost.rle_bytes = head + rle;
+
+  ForFrame frame = for_frame(values.data(), n);
+  bytes[size_t(ColumnCodec::FOR)] = head + unsigned_leb128_size(frame.base) +
+                                    unsigned_leb128_size(frame.width) +
+                                    for_packed_size(n, frame.width);
+
+  // 不同值超过一半时字典不可能占优，提前放弃以免为每列建完整的哈希表
+  std::vector<std::pair<uint64_t, size_t>> dict;
+  absl::flat_hash_map<uint64_t, uint32_t> codes;
+  size_t dict_bytes = SIZE_MAX;
+  if (build_dict(values, n / 2, dict, codes)) {
+    dict_bytes = head + unsigned_leb128_size(dict.size());
+    for (size_t i = 0; i < dict.size(); ++i)
+      dict_bytes += unsigned_leb128_size(dict[i].first) +
+                    dict[i].second * unsigned_leb128_size(i);
+  }
+  bytes[size_t(ColumnCodec::DICT)] = dict_bytes;
+
+  if (legacy) {
+    cost.best = bytes[size_t(ColumnCodec::DELTA)] <
+                        bytes[size_t(ColumnCodec::RAW)]
+                    ? ColumnCodec::DELTA
+                    : ColumnCodec::RAW;
+    return cost;
+  }
+  size_t best = size_t(ColumnCodec::RAW);
+  for (ColumnCodec codec : COLUMN_CODECS) {
+    size_t c = size_t(codec);
+    if (codec != ColumnCodec::FOR && bytes[c] < bytes[best])
+      best = c;
+  }
+  // 位打包后的字节边界与值不对齐，xz 对其压缩效果不如按字节对齐的编码，
+  // 只在不超过其余最优者的 3/4 时使用。位宽为不小于 32 的 8 的倍数时
+  // （如随机的十六进制 id）每个值占整数个字节，直接比较
+  size_t for_bytes = bytes[size_t(ColumnCodec::FOR)];
+  bool aligned = frame.width >= 32 && frame.width % 8 == 0;
+  if (aligned ? for_bytes < bytes[best] : for_bytes * 4 <= bytes[best] * 3)
+    best = size_t(ColumnCodec::FOR);
+  cost.best = ColumnCodec(best);
+  return cost;
+}
+
+void write_column(std::string &writer, const std::vector<uint64_t> &values,
+                  ColumnCodec codec, bool standalone) {
+  put_unsigned(writer, uint64_t(codec));
+  if (standalone && codec != ColumnCodec::RAW && codec != ColumnCodec::DELTA)
+    put_unsigned(writer, values.size());
+
+  switch (codec) {
+  case ColumnCodec::RAW:
+    for (uint64_t v : values) {
+      if (standalone)
+        put_signed(writer, int64_t(v));
+      else
+        put_unsigned(writer, v);
+    }
+    break;
+  case ColumnCodec::DELTA: {
+    uint64_t prev = 0;
+    for (uint64_t v : values) {
+      put_signed(writer, int64_t(v - prev));
+      prev = v;
+    }
+    break;
+  }
+  case ColumnCodec::FOR: {
+    char buff[20];
+    size_t offset = 0;
+    SubTokenCompressor::write_bitpacked(writer, buff, offset, values,
+                                        for_frame(values.data(),
+                                                  values.size()));
+    break;
+  }
+  case ColumnCodec::DELTA_OF_DELTA: {
+    DeltaOfDelta state;
+    for (uint64_t v : values)
+      put_signed(writer, state.next(v));
+    break;
+  }
+  case ColumnCodec::DICT: {
+    std::vector<std::pair<uint64_t, size_t>> dict;
+    absl::flat_hash_map<uint64_t, uint32_t> codes;
+    build_dict(values, values.size(), dict, codes);
+    put_unsigned(writer, dict.size());
+    for (auto &entry : dict)
+      put_unsigned(writer, entry.first);
+    for (uint64_t v : values)
+      put_unsigned(writer, codes.find(v)->second);
+    break;
+  }
+  }
+}
+
+const char *read_column(const char *cur, const char *end, size_t n,
+                        bool standalone, std::vector<uint64_t> &out,
+                        const std::string &stream_name) {
+  using STC = SubTokenCompressor;
+  uint64_t flag = STC::read_unsigned_leb128(cur, end);
+  if (flag >= COLUMN_CODEC_COUNT ||
+      std::find(std::begin(COLUMN_CODECS), std::end(COLUMN_CODECS),
+                ColumnCodec(flag)) == std::end(COLUMN_CODECS))
+    handle_error("Unknown encoding flag in stream: " + stream_name);
+  auto codec = ColumnCodec(flag);
+  // 独立数字流的 RAW 与 DELTA 读到流尾，其余编码写有值的个数
+  bool to_end = false;
+  if (standalone) {
+    if (codec == ColumnCodec::RAW || codec == ColumnCodec::DELTA)
+      to_end = true;
+    else
+      n = STC::read_unsigned_leb128(cur, end);
+  }
+
+  switch (codec) {
+  case ColumnCodec::RAW:
+    for (size_t i = 0; to_end ? cur < end : i < n; ++i) {
+      out.push_back(standalone ? uint64_t(STC::read_signed_leb128(cur, end))
+                               : STC::read_unsigned_leb128(cur, end));
+    }
+    break;
+  case ColumnCodec::DELTA: {
+    uint64_t prev = 0;
+    for (size_t i = 0; to_end ? cur < end : i < n; ++i) {
+      prev += uint64_t(STC::read_signed_leb128(cur, end));
+      out.push_back(prev);
+    }
+    break;
+  }
+  case ColumnCodec::FOR:
+    cur = STC::read_bitpacked(cur, end, n, out);
+    break;
+  case ColumnCodec::DELTA_OF_DELTA: {
+    DeltaOfDelta state;
+    for (size_t i = 0; i < n; ++i)
+      out.push_back(state.undo(STC::read_signed_leb128(cur, end)));
+    break;
+  }
+  case ColumnCodec::DICT: {
+    uint64_t dict_size = STC::read_unsigned_leb128(cur, end);
+    // 每个字典项至少占一个字节
+    if (dict_size > uint64_t(end - cur))
+      handle_error("Invalid dictionary size in stream: " + stream_name);
+    std::vector<uint64_t> dict(dict_size);
+    for (auto &value : dict)
+      value = STC::read_unsigned_leb128(cur, end);
+    for (size_t i = 0; i < n; ++i) {
+      uint64_t code = STC::read_unsigned_leb128(cur, end);
+      if (code >= dict.size())
+        handle_error("Invalid dictionary code in stream: " + stream_name);
+      out.push_back(dict[code]);
+    }
+    break;
+  }
+  }
+  return cur;
+}
@@ -1,19 +1,19 @@
+#include "ColumnCodec.hpp"
 #include "internal/out.hpp"
+#include "utils/BitPacking.hpp"
+#include "utils/StreamVByte.hpp"
 #include <TokenManager.hpp>
 #include <cstddef>
 #include <cstdint>
-#include <fstream>
 #include <iostream>
 #include <string>
-#include <sys/wait.h>
 #include <utils/util.hpp>
 #include <vector>
 // #include <filesystem>
 
 // namespace fs = std::filesystem;
-void SubTokenCompressor::write_unsigned_leb128(std::ofstream &writer,
-                                               char *buff, size_t &offset,
-                                               uint64_t value) {
+void SubTokenCompressor::write_unsigned_leb128(std::string &writer, char *buff,
+                                               size_t &offset, uint64_t value) {
   do {
     uint8_t byte = value & 0x7F;
     value >>= 7;
@@ -22,110 +22,212 @@ void SubTokenCompressor::write_unsigned_leb128(std::ofstream &writer,
     buff[offset++] = byte;
   } while (value != 0);
 
-  writer.write(buff, offset);
+  writer.append(buff, offset);
   offset = 0;
 }
-void SubTokenCompressor::encode_and_store_base_binary(
-    const std::string &output_dir, const uint32_t key1, const uint32_t key2,
-    const std::vector<uint64_t> &vec) {
 
-  // 1. 如果数据为空，直接返回
-  if (vec.empty()) {
-    return;
-  }
+void SubTokenCompressor::write_bitpacked(std::string &writer, char *buff,
+                                         size_t &offset,
+                                         const std::vector<uint64_t> &vec,
+                                         ForFrame frame) {
+  write_unsigned_leb128(writer, buff, offset, frame.base);
+  write_unsigned_leb128(writer, buff, offset, frame.width);
+  for_pack(vec.data(), vec.size(), frame, writer);
+}
 
-  // 2. 构造输出路径
-  std::string output_path = output_dir + "/l" + std::to_string(key1) + "_" +
-                            std::to_string(key2) + ".bin";
+const char *SubTokenCompressor::read_bitpacked(const char *cur,
+                                               const char *end, size_t n,
+                                               std::vector<uint64_t> &out) {
+  ForFrame frame;
+  frame.base = read_unsigned_leb128(cur, end);
+  frame.width = uint32_t(read_unsigned_leb128(cur, end));
+  if (frame.width > 64 ||
+      size_t(end - cur) < for_packed_size(n, frame.width))
+    handle_error("Truncated bit-packed stream");
+  size_t start = out.size();
+  out.resize(start + n);
+  for_unpack(cur, n, frame, out.data() + start);
+  return cur + for_packed_size(n, frame.width);
+}
 
-  // 3. 打开文件写入流
-  std::ofstream writer(output_path, std::ios::binary);
-  if (!writer.is_open()) {
-    handle_error(format(
-        "encode_and_store_base_binary - Failed to create output file: %s",
-        output_path.c_str()));
-  }
+// 值的个数（LEB128）之后追加 svb_encode 的输出
+template <typename Buffer>
+static void append_stream_vbyte(Buffer &out, const uint32_t *values,
+                                size_t n) {
+  size_t start = out.size();
+  out.resize(start + 10 + svb_max_size(n));
+  auto *dst = reinterpret_cast<uint8_t *>(&out[start]);
+  size_t len = 0;
+  uint64_t count = n;
+  do {
+    uint8_t byte = count & 0x7F;
+    count >>= 7;
+    dst[len++] = count ? byte | 0x80 : byte;
+  } while (count);
+  len += svb_encode(values, n, dst + len);
+  out.resize(start + len);
+}
 
-  // 4. 抽样分析数据以决定编码策略
-  size_t sample_size = std::min<size_t>(10, vec.size());
-  std::vector<int64_t> sample_values(vec.begin(), vec.begin() + sample_size);
-  bool is_delta_mode = calc_compression_mode(sample_values);
+void SubTokenCompressor::read_stream_vbyte(const std::string &data,
+                                           std::vector<uint32_t> &out) {
+  const char *cur = data.data(), *end = cur + data.size();
+  uint64_t n = read_unsigned_leb128(cur, end);
+  // 每个值至少占一个数据字节
+  if (n > uint64_t(end - cur))
+    handle_error("Truncated Stream VByte stream");
+  size_t start = out.size();
+  out.resize(start + n);
+  if (!svb_decode(reinterpret_cast<const uint8_t *>(cur), end - cur, n,
+                  out.data() + start))
+    handle_error("Truncated Stream VByte stream");
+}
 
-  char buffer[4096 + 20] = {0};
-  size_t offset = 0;
-  write_unsigned_leb128(writer, buffer, offset,
-                        is_delta_mode ? 1 : 0); // 标记编码方式
+std::string SubTokenCompressor::base_binary_name(uint32_t key1, uint32_t key2) {
+  return "l" + std::to_string(key1) + "_" + std::to_string(key2) + ".bin";
+}
 
-  // 5. 根据评估结果选择编码方式
+std::string SubTokenCompressor::timestamp_name(uint32_t format) {
+  return "t" + std::to_string(format) + ".bin";
+}
 
-  int64_t val;
-  uint8_t byte;
-  bool more;
-  if (is_delta_mode) {
-    int64_t prev = 0;
-    for (const int64_t num : vec) {
-      val = num - prev;
-      prev = num;
-      // 内联实现有符号LEB128（避免函数调用开销）
-      do {
-        byte = val & 0x7F;
-        val >>= 7;
-        more = !((val == 0 && (byte & 0x40) == 0) ||
-                 (val == -1 && (byte & 0x40) != 0));
-        if (more)
-          byte |= 0x80;
-        buffer[offset++] = byte;
-      } while (more);
-      if (offset >= 4096) {
-        writer.write(buffer, offset);
-        offset = 0;
-      }
+std::string
+SubTokenCompressor::matrix_name(uint64_t dict_id, bool is_delta,
+                                const std::vector<int32_t> &lengths,
+                                const std::vector<SubTokenType> &types) {
+  std::string name = "_" + std::to_string(dict_id);
+  if (is_delta)
+    name += "_delta";
+  for (size_t i = 0; i < lengths.size(); ++i) {
+    name += "_";
+    if (i < types.size() && types[i] != SubTokenType::TAGGED)
+      name += char(types[i]);
+    name += std::to_string(lengths[i]);
+  }
+  return name + ".bin";
+}
+
+bool SubTokenCompressor::parse_matrix_name(const std::string &name,
+                                           uint64_t &dict_id, bool &is_delta,
+                                           std::vector<int32_t> &lengths,
+                                           std::vector<SubTokenType> &types) {
+  static const std::string suffix = ".bin";
+  if (name.size() < 2 + suffix.size() || name[0] != '_' ||
+      name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0)
+    return false;
+
+  std::vector<std::string> parts;
+  size_t start = 1, end = name.size() - suffix.size(), sep;
+  while ((sep = name.find('_', start)) < end) {
+    parts.push_back(name.substr(start, sep - start));
+    start = sep + 1;
+  }
+  parts.push_back(name.substr(start, end - start));
+
+  if (!try_stoull(parts[0], dict_id))
+    return false;
+  size_t i = 1;
+  is_delta = i < parts.size() && parts[i] == "delta";
+  if (is_delta)
+    ++i;
+  lengths.clear();
+  types.clear();
+  for (; i < parts.size(); ++i) {
+    auto part = parts[i];
+    auto type = SubTokenType::TAGGED;
+    if (!part.empty() && (part[0] == char(SubTokenType::DECIMAL) ||
+                          part[0] == char(SubTokenType::HEX_LOWER) ||
+                          part[0] == char(SubTokenType::HEX_UPPER))) {
+      type = SubTokenType(part[0]);
+      part.erase(0, 1);
     }
-  } else {
-    // 使用原始值
-    for (int64_t num : vec) {
-      val = num;
-      do {
-        byte = val & 0x7F;
-        val >>= 7;
-        more = !((val == 0 && (byte & 0x40) == 0) ||
-                 (val == -1 && (byte & 0x40) != 0));
-        if (more)
-          byte |= 0x80;
-        buffer[offset++] = byte;
-      } while (more);
-      if (offset >= 4096) {
-        writer.write(buffer, offset);
-        offset = 0;
-      }
+    types.push_back(type);
+    uint32_t len;
+    if (part == "-1")
+      lengths.push_back(-1);
+    else if (try_stoul(part, len))
+      lengths.push_back(int32_t(len));
+    else
+      return false;
+    // 十六进制列必须定长，且不超过两个值
+    bool is_hex = type == SubTokenType::HEX_LOWER ||
+                  type == SubTokenType::HEX_UPPER;
+    if (is_hex && (lengths.back() < 1 || lengths.back() > 32))
+      return false;
+  }
+  return true;
+}
+
+uint64_t SubTokenCompressor::read_unsigned_leb128(const char *&cur,
+                                                  const char *end) {
+  uint64_t value = 0;
+  for (int shift = 0; cur < end && shift < 64; shift += 7) {
+    uint8_t byte = *cur++;
+    value |= uint64_t(byte & 0x7F) << shift;
+    if (!(byte & 0x80))
+      return value;
+  }
+  handle_error("Truncated LEB128 stream");
+  return 0;
+}
+
+int64_t SubTokenCompressor::read_signed_leb128(const char *&cur,
+                                               const char *end) {
+  uint64_t value = 0;
+  for (int shift = 0; cur < end && shift < 64;) {
+    uint8_t byte = *cur++;
+    value |= uint64_t(byte & 0x7F) << shift;
+    shift += 7;
+    if (!(byte & 0x80)) {
+      // 符号扩展
+      if (shift < 64 && (byte & 0x40))
+        value |= ~uint64_t(0) << shift;
+      return int64_t(value);
     }
   }
-  // 最后一块数据写入文件
-  if (offset > 0) {
-    writer.write(buffer, offset);
+  handle_error("Truncated LEB128 stream");
+  return 0;
+}
+
+ColumnCost SubTokenCompressor::encode_and_store_base_binary(
+    ChunkArchive &archive, const uint32_t key1, const uint32_t key2,
+    const std::vector<uint64_t> &vec, bool legacy) {
+
+  // 1. 如果数据为空，直接返回
+  if (vec.empty()) {
+    return {};
+  }
+
+  // 2. 在归档中创建对应的流
+  auto &writer = archive.file(base_binary_name(key1, key2));
+
+  // 3. 对整列估计各编码方式写出的大小，选出最小者
+  auto cost = estimate_column(vec, true, legacy);
+  write_column(writer, vec, cost.best, true);
+  return cost;
+}
+
+ColumnCost SubTokenCompressor::encode_and_store_timestamps(
+    ChunkArchive &archive, const uint32_t format,
+    const std::vector<uint64_t> &vec) {
+  if (vec.empty()) {
+    return {};
   }
-  writer.flush();
-  writer.close();
+  auto &writer = archive.file(timestamp_name(format));
+  // 仍给出各编码方式的估计供 --codec-stats 比较
+  auto cost = estimate_column(vec, true);
+  cost.best = ColumnCodec::DELTA_OF_DELTA;
+  write_column(writer, vec, cost.best, true);
+  return cost;
 }
 
-void SubTokenCompressor::encode_and_store_trans_matrix_lsb(
-    const std::string &output_dir, const std::string &output_name,
+void SubTokenCompressor::encode_trans_matrix_lsb(
+    std::string &writer, bool is_delta,
     const std::vector<std::vector<uint64_t>> &trans_num_matrix,
-    size_t expected_row_length) {
+    size_t expected_row_length, std::vector<ColumnCost> *costs, bool legacy) {
   if (trans_num_matrix.empty()) {
     return;
   }
 
-  // 创建输出文件
-  std::string output_path = output_dir + "/" + output_name + ".bin";
-  std::ofstream writer(output_path, std::ios::binary);
-  if (!writer.is_open()) {
-    handle_error(format(
-        "encode_and_store_trans_matrix_lsb - Failed to create output file: %s",
-        output_path.c_str()));
-  }
-  DEBUG("create output file: %s", output_path.c_str())
-
   // 写入行数和列数
   char buffer[4096 + 20] = {0};
   size_t offset = 0;
@@ -134,10 +236,7 @@ void SubTokenCompressor::encode_and_store_trans_matrix_lsb(
   DEBUG("write row num: %lu, col num: %lu", trans_num_matrix.size(),
         expected_row_length)
 
-  bool is_delta = output_name.find("delta") != std::string::npos;
-
   uint8_t byte;
-  bool more;
 
   if (is_delta) {
     for (size_t row_idx = 0; row_idx < trans_num_matrix.size(); ++row_idx) {
@@ -157,7 +256,7 @@ void SubTokenCompressor::encode_and_store_trans_matrix_lsb(
           buffer[offset++] = byte;
         } while (val != 0);
         if (offset >= 4096) {
-          writer.write(buffer, offset);
+          writer.append(buffer, offset);
           offset = 0;
         }
       }
@@ -170,80 +269,26 @@ void SubTokenCompressor::encode_and_store_trans_matrix_lsb(
                             row.size(), expected_row_length));
       }
 
-      // 取样分析是否使用 delta 编码
-      size_t sample_size = std::min<size_t>(10, row.size());
-      // 暂时不管 row 为空的情况
-      // if (sample_size == 0) {
-      //   write_unsigned_leb128(writer, 0); // 标记为原始值
-      //   continue;
-      // }
-      std::vector<int64_t> sample_values(row.begin(),
-                                         row.begin() + sample_size);
-      bool is_delta_mode = calc_compression_mode(sample_values);
-      write_unsigned_leb128(writer, buffer, offset,
-                            is_delta_mode ? 1 : 0); // 标记编码方式
-      DEBUG("write delta mode flag: %d, first ele: %lu", is_delta_mode ? 1 : 0,
-            row[0])
-      if (is_delta_mode) {
-        // 使用 delta 编码
-        int64_t val;
-        int64_t prev = 0;
-        for (const int64_t num : row) {
-          val = num - prev;
-          prev = num;
-          // 内联实现有符号LEB128（避免函数调用开销）
-          do {
-            byte = val & 0x7F;
-            val >>= 7;
-            more = !((val == 0 && (byte & 0x40) == 0) ||
-                     (val == -1 && (byte & 0x40) != 0));
-            if (more)
-              byte |= 0x80;
-            buffer[offset++] = byte;
-          } while (more);
-          if (offset >= 4096) {
-            writer.write(buffer, offset);
-            offset = 0;
-          }
-        }
-      } else {
-        // 不使用 delta 编码
-        uint64_t val;
-        for (uint64_t num : row) {
-          val = num;
-          do {
-            byte = val & 0x7F;
-            val >>= 7;
-            if (val != 0)
-              byte |= 0x80;
-            buffer[offset++] = byte;
-          } while (val != 0);
-          if (offset >= 4096) {
-            writer.write(buffer, offset);
-            offset = 0;
-          }
-        }
-      }
+      // 对整列估计各编码方式写出的大小，选出最小者
+      auto cost = estimate_column(row, false, legacy);
+      write_column(writer, row, cost.best, false);
+      DEBUG("write column codec: %s, first ele: %lu",
+            column_codec_name(cost.best), row[0])
+      if (costs)
+        costs->push_back(cost);
     }
   }
 
   // 最后一块数据写入文件
   if (offset > 0) {
-    writer.write(buffer, offset);
+    writer.append(buffer, offset);
   }
-  writer.flush();
-  writer.close();
 }
 
 void SubTokenCompressor::encode_and_store_template_id(
-    const std::string &output_dir, const std::string &output_name,
+    ChunkArchive &archive, const std::string &output_name,
     const std::vector<uint32_t> &tmpl_ids) {
-  std::string output_path = output_dir + "/" + output_name + ".bin";
-  std::ofstream writer(output_path, std::ios::binary);
-  if (!writer.is_open()) {
-    handle_error(
-        format("Failed to create output file: %s", output_path.c_str()));
-  }
+  auto &writer = archive.file(output_name);
   char buffer[4096 + 20];
   size_t buffer_size = 0;
   uint64_t val;
@@ -258,15 +303,20 @@ void SubTokenCompressor::encode_and_store_template_id(
       buffer[buffer_size++] = byte;
     } while (val != 0);
     if (buffer_size >= 4096) {
-      writer.write(buffer, buffer_size);
+      writer.append(buffer, buffer_size);
       buffer_size = 0;
     }
   }
   if (buffer_size > 0) {
-    writer.write(buffer, buffer_size);
+    writer.append(buffer, buffer_size);
   }
-  writer.flush();
-  writer.close();
+}
+
+void SubTokenCompressor::encode_and_store_template_id_svb(
+    ChunkArchive &archive, const std::string &output_name,
+    const std::vector<uint32_t> &tmpl_ids) {
+  append_stream_vbyte(archive.file(output_name), tmpl_ids.data(),
+                      tmpl_ids.size());
 }
 
 bool SubTokenCompressor::calc_compression_mode(std::vector<int64_t> &nums) {
@@ -316,80 +366,26 @@ void SubTokenCompressor::batch_encode_dynamic(
   }
 }
 
-void SubTokenCompressor::compress_chunk(const std::vector<uint8_t> &buffer,
-                                        const std::string &output_path) {
-  std::cout << "Compressing data to file: " << output_path << std::endl;
-  auto binary_file_path = output_path + "/tokenid.bin";
-
-  std::ofstream writer(binary_file_path, std::ios::binary);
-  if (!writer.is_open()) {
-    handle_error(
-        format("Failed to create output file: %s", binary_file_path.c_str()));
-  }
-  writer.write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
-  writer.flush();
-  writer.close();
-
-  auto xz_file_path = output_path + ".tar.xz";
-
-  std::vector<const char *> args = {
-      "tar",
-      "-cf",
-      xz_file_path.c_str(),
-      "--use-compress-program=xz --extreme",
-      "-C",
-      output_path.c_str(),
-      ".",
-      nullptr // 参数列表必须以 nullptr 结束
-  };
-
-  int stderr_pipe[2];
-  if (pipe(stderr_pipe)) {
-    handle_error("Failed to create pipe");
-  }
-
-  pid_t pid = fork();
-  if (pid == -1) {
-    close(stderr_pipe[0]);
-    close(stderr_pipe[1]);
-    handle_error("fork failed");
+bool SubTokenCompressor::batch_encode_dynamic_svb(
+    const std::vector<uint64_t> &dynamic, std::vector<uint8_t> &buffer) {
+  std::vector<uint32_t> ids(dynamic.size());
+  for (size_t i = 0; i < dynamic.size(); ++i) {
+    if (dynamic[i] > UINT32_MAX)
+      return false;
+    ids[i] = uint32_t(dynamic[i]);
   }
+  append_stream_vbyte(buffer, ids.data(), ids.size());
+  return true;
+}
 
-  if (pid == 0) { // 子进程
-    // 重定向 stderr 到管道
-    dup2(stderr_pipe[1], STDERR_FILENO);
-    close(stderr_pipe[0]);
-    close(stderr_pipe[1]);
-
-    // 执行 tar 命令（注意：const_cast 因 execvp 需要 char* const*）
-    execvp("tar", const_cast<char *const *>(args.data()));
-
-    // 如果执行到这里说明 execvp 失败
-    std::cerr << "execvp failed" << std::endl;
-    _exit(EXIT_FAILURE);
-  } else {                 // 父进程
-    close(stderr_pipe[1]); // 关闭写端
-
-    // 读取子进程的错误输出
-    std::ostringstream error_stream;
-    char buffer[256];
-
-    ssize_t count;
-    while ((count = read(stderr_pipe[0], buffer, sizeof(buffer))) > 0) {
-      error_stream.write(buffer, count);
-    }
-    close(stderr_pipe[0]);
-
-    // 等待子进程结束
-    int status;
-    if (waitpid(pid, &status, 0) == -1) {
-      handle_error("waitpid failed");
-    }
-
-    // 检查命令是否成功
-    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
-      std::string error_msg = "tar command failed: " + error_stream.str();
-      handle_error(error_msg);
-    }
-  }
-}
\ No newline at end of file
+void SubTokenCompressor::compress_chunk(const std::vector<uint8_t> &buffer,
+                                        const char *token_id_stream,
+                                        ChunkArchive &archive,
+                                        const Codec &codec) {
+  std::cout << "Compressing data to file: " << archive.path()
+            << codec_extension(codec) << std::endl;
+  archive.file(token_id_stream)
+      .assign(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+  // 整个块在内存中打包并压缩，一次顺序写出
+  archive.write(codec);
+}
@@ -3,10 +3,12 @@
 #include <cstdint>
 #include <cstdio>
 #include <iostream>
+#include <utils/Timestamp.hpp>
 #include <utils/util.hpp>
 
 DynamicSubTokenManager::DynamicSubTokenManager() {
   num_subtoken_vec.resize(16); // 16位数字集合
+  timestamp_vec.resize(timestamp_format_count());
 }
 
 void DynamicSubTokenManager::get_or_register_token_no_split(
@@ -63,10 +65,19 @@ DynamicSubTokenManager::get_or_register_string(const std::string &token) {
 }
 
 void DynamicSubTokenManager::process_base_dict_for_vec(
-    const std::string &output_dir) {
+    ChunkArchive &archive,
+    std::vector<std::pair<std::string, ColumnCost>> &costs, bool legacy) {
   for (size_t i = 1; i <= 15; i++) {
-    SubTokenCompressor::encode_and_store_base_binary(output_dir, i, 0,
-                                                     num_subtoken_vec[i]);
+    auto cost = SubTokenCompressor::encode_and_store_base_binary(
+        archive, i, 0, num_subtoken_vec[i], legacy);
+    if (cost.values > 0)
+      costs.emplace_back(SubTokenCompressor::base_binary_name(i, 0), cost);
+  }
+  for (uint32_t i = 0; i < timestamp_vec.size(); i++) {
+    auto cost = SubTokenCompressor::encode_and_store_timestamps(
+        archive, i, timestamp_vec[i]);
+    if (cost.values > 0)
+      costs.emplace_back(SubTokenCompressor::timestamp_name(i), cost);
   }
 }
 
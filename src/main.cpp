@@ -1,3 +1,4 @@
+#include <LogDecoder.hpp>
 #include <arg.hpp>
 #include <iostream>
 #include <processor.hpp>
@@ -6,5 +7,10 @@ int main(int argc, char *argv[]) {
   // 解析命令行参数
   Args args = parse_args(argc, argv);
 
-  columnar_subtoken_compress_logs(args);
+  if (args.get_line > 0)
+    get_logs(args);
+  else if (args.decompress)
+    decompress_logs(args);
+  else
+    columnar_subtoken_compress_logs(args);
 }
@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utils/BitPacking.hpp>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LOGMD_BITPACKING_X86 1
+#include <immintrin.h>
+#endif
+
+static constexpr size_t BLOCK = 256, LANES = 8;
+
+ForFrame for_frame(const uint64_t *values, size_t n) {
+  ForFrame frame;
+  if (n == 0)
+    return frame;
+  // 分 4 路无分支求最值，比 minmax_element 的逐个比较分支快数倍
+  uint64_t lo[4], hi[4];
+  for (size_t j = 0; j < 4; ++j)
+    lo[j] = hi[j] = values[0];
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    for (size_t j = 0; j < 4; ++j) {
+      lo[j] = std::min(lo[j], values[i + j]);
+      hi[j] = std::max(hi[j], values[i + j]);
+    }
+  }
+  for (; i < n; ++i) {
+    lo[0] = std::min(lo[0], values[i]);
+    hi[0] = std::max(hi[0], values[i]);
+  }
+  frame.base = *std::min_element(lo, lo + 4);
+  uint64_t range = *std::max_element(hi, hi + 4) - frame.base;
+  frame.width = range ? 64 - __builtin_clzll(range) : 0;
+  return frame;
+}
+
+static size_t sequential_size(size_t n, uint32_t width) {
+  return (n * width + 7) / 8;
+}
+
+size_t for_packed_size(size_t n, uint32_t width) {
+  if (width > 32)
+    return sequential_size(n, width);
+  return n / BLOCK * (BLOCK / 8) * width + sequential_size(n % BLOCK, width);
+}
+
+// ---------------------------------------------------------------------------
+// 整块：8 个通道各自把 32 个值首尾相接地写入 width 个 32 位字
+// ---------------------------------------------------------------------------
+
+#ifndef LOGMD_BITPACKING_X86
+// 没有 SIMD 指令时的实现，与下面的 SSE2 / AVX2 版本输出相同
+static void pack_block_scalar(const uint32_t *in, uint32_t width,
+                              uint32_t *out) {
+  for (size_t j = 0; j < LANES; ++j) {
+    uint64_t acc = 0;
+    uint32_t bits = 0, word = 0;
+    for (size_t k = 0; k < BLOCK / LANES; ++k) {
+      acc |= uint64_t(in[k * LANES + j]) << bits;
+      bits += width;
+      if (bits >= 32) {
+        out[word++ * LANES + j] = uint32_t(acc);
+        acc >>= 32;
+        bits -= 32;
+      }
+    }
+  }
+}
+
+static void unpack_block_scalar(const uint32_t *in, uint32_t width,
+                                uint64_t base, uint64_t *out) {
+  uint64_t mask = (uint64_t(1) << width) - 1;
+  for (size_t j = 0; j < LANES; ++j) {
+    uint64_t acc = 0;
+    uint32_t bits = 0, word = 0;
+    for (size_t k = 0; k < BLOCK / LANES; ++k) {
+      if (bits < width) {
+        acc |= uint64_t(in[word++ * LANES + j]) << bits;
+        bits += 32;
+      }
+      out[k * LANES + j] = base + (acc & mask);
+      acc >>= width;
+      bits -= width;
+    }
+  }
+}
+#else
+// SSE2 是 x86-64 的基线指令集，每次处理 4 个通道，一块分两半处理。
+// 移位数是同一个寄存器中的标量，移出 32 位以上时结果为 0
+static void pack_block_sse2(const uint32_t *in, uint32_t width,
+                            uint32_t *out) {
+  for (size_t half = 0; half < LANES; half += 4) {
+    __m128i acc = _mm_setzero_si128();
+    uint32_t shift = 0, word = 0;
+    for (size_t k = 0; k < BLOCK / LANES; ++k) {
+      __m128i v = _mm_loadu_si128(
+          reinterpret_cast<const __m128i *>(in + k * LANES + half));
+      acc = _mm_or_si128(acc, _mm_sll_epi32(v, _mm_cvtsi32_si128(shift)));
+      shift += width;
+      if (shift >= 32) {
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i *>(out + word++ * LANES + half), acc);
+        shift -= 32;
+        // 值小于 2^width，shift 为 0 时右移 width 位得到 0
+        acc = _mm_srl_epi32(v, _mm_cvtsi32_si128(width - shift));
+      }
+    }
+  }
+}
+
+static void unpack_block_sse2(const uint32_t *in, uint32_t width,
+                              uint64_t base, uint64_t *out) {
+  const __m128i mask = _mm_set1_epi32(int32_t((uint64_t(1) << width) - 1)),
+                zero = _mm_setzero_si128(),
+                base_v = _mm_set1_epi64x(int64_t(base));
+  for (size_t half = 0; half < LANES; half += 4) {
+    for (size_t k = 0; k < BLOCK / LANES; ++k) {
+      uint32_t bit = uint32_t(k) * width, word = bit / 32, off = bit % 32;
+      auto *src = reinterpret_cast<const __m128i *>(in + word * LANES + half);
+      __m128i v =
+          _mm_srl_epi32(_mm_loadu_si128(src), _mm_cvtsi32_si128(off));
+      if (off + width > 32)
+        v = _mm_or_si128(v, _mm_sll_epi32(_mm_loadu_si128(src + 2),
+                                          _mm_cvtsi32_si128(32 - off)));
+      v = _mm_and_si128(v, mask);
+      auto *dst = reinterpret_cast<__m128i *>(out + k * LANES + half);
+      _mm_storeu_si128(dst, _mm_add_epi64(_mm_unpacklo_epi32(v, zero), base_v));
+      _mm_storeu_si128(dst + 1,
+                       _mm_add_epi64(_mm_unpackhi_epi32(v, zero), base_v));
+    }
+  }
+}
+
+// AVX2 一次处理全部 8 个通道，只在运行时确认 CPU 支持后使用
+__attribute__((target("avx2"))) static void
+pack_block_avx2(const uint32_t *in, uint32_t width, uint32_t *out) {
+  __m256i acc = _mm256_setzero_si256();
+  uint32_t shift = 0, word = 0;
+  for (size_t k = 0; k < BLOCK / LANES; ++k) {
+    __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + k * LANES));
+    acc = _mm256_or_si256(acc, _mm256_sll_epi32(v, _mm_cvtsi32_si128(shift)));
+    shift += width;
+    if (shift >= 32) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + word++ * LANES),
+                          acc);
+      shift -= 32;
+      acc = _mm256_srl_epi32(v, _mm_cvtsi32_si128(width - shift));
+    }
+  }
+}
+
+__attribute__((target("avx2"))) static void
+unpack_block_avx2(const uint32_t *in, uint32_t width, uint64_t base,
+                  uint64_t *out) {
+  const __m256i mask =
+                    _mm256_set1_epi32(int32_t((uint64_t(1) << width) - 1)),
+                base_v = _mm256_set1_epi64x(int64_t(base));
+  for (size_t k = 0; k < BLOCK / LANES; ++k) {
+    uint32_t bit = uint32_t(k) * width, word = bit / 32, off = bit % 32;
+    auto *src = reinterpret_cast<const __m256i *>(in + word * LANES);
+    __m256i v =
+        _mm256_srl_epi32(_mm256_loadu_si256(src), _mm_cvtsi32_si128(off));
+    if (off + width > 32)
+      v = _mm256_or_si256(v, _mm256_sll_epi32(_mm256_loadu_si256(src + 1),
+                                              _mm_cvtsi32_si128(32 - off)));
+    v = _mm256_and_si256(v, mask);
+    auto *dst = reinterpret_cast<__m256i *>(out + k * LANES);
+    _mm256_storeu_si256(
+        dst, _mm256_add_epi64(
+                 _mm256_cvtepu32_epi64(_mm256_castsi256_si128(v)), base_v));
+    _mm256_storeu_si256(
+        dst + 1, _mm256_add_epi64(
+                     _mm256_cvtepu32_epi64(_mm256_extracti128_si256(v, 1)),
+                     base_v));
+  }
+}
+
+static const bool has_avx2 = [] {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") != 0;
+}();
+#endif
+
+static void pack_block(const uint32_t *in, uint32_t width, uint32_t *out) {
+#ifdef LOGMD_BITPACKING_X86
+  if (has_avx2)
+    return pack_block_avx2(in, width, out);
+  return pack_block_sse2(in, width, out);
+#else
+  return pack_block_scalar(in, width, out);
+#endif
+}
+
+static void unpack_block(const uint32_t *in, uint32_t width, uint64_t base,
+                         uint64_t *out) {
+#ifdef LOGMD_BITPACKING_X86
+  if (has_avx2)
+    return unpack_block_avx2(in, width, base, out);
+  return unpack_block_sse2(in, width, base, out);
+#else
+  return unpack_block_scalar(in, width, base, out);
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// 顺序存放：第 i 个值位于第 i * width 位起，小端序
+// ---------------------------------------------------------------------------
+
+static void pack_sequential(const uint64_t *values, size_t n, ForFrame frame,
+                            char *out) {
+  uint32_t width = frame.width;
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t v = values[i] - frame.base;
+    size_t bit = i * width, byte = bit / 8, shift = bit % 8;
+    // 至多跨 9 个字节
+    for (size_t b = 0; shift + width > b * 8; ++b) {
+      uint64_t part = b == 0 ? v << shift
+                             : (b * 8 - shift < 64 ? v >> (b * 8 - shift) : 0);
+      out[byte + b] |= char(part & 0xFF);
+    }
+  }
+}
+
+static void unpack_sequential(const char *data, size_t size, size_t n,
+                              ForFrame frame, uint64_t *out) {
+  uint32_t width = frame.width;
+  uint64_t mask = width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+  for (size_t i = 0; i < n; ++i) {
+    size_t bit = i * width, byte = bit / 8, shift = bit % 8;
+    unsigned char buf[9] = {0};
+    std::memcpy(buf, data + byte, std::min<size_t>(9, size - byte));
+    uint64_t lo;
+    std::memcpy(&lo, buf, 8);
+    uint64_t v = lo >> shift;
+    if (shift + width > 64)
+      v |= uint64_t(buf[8]) << (64 - shift);
+    out[i] = frame.base + (v & mask);
+  }
+}
+
+void for_pack(const uint64_t *values, size_t n, ForFrame frame,
+              std::string &out) {
+  if (frame.width == 0 || n == 0)
+    return;
+  size_t start = out.size();
+  out.resize(start + for_packed_size(n, frame.width), '\0');
+  char *dst = &out[start];
+
+  size_t blocks = frame.width <= 32 ? n / BLOCK : 0;
+  uint32_t in[BLOCK], packed[BLOCK];
+  for (size_t blk = 0; blk < blocks; ++blk) {
+    for (size_t i = 0; i < BLOCK; ++i)
+      in[i] = uint32_t(values[blk * BLOCK + i] - frame.base);
+    pack_block(in, frame.width, packed);
+    size_t bytes = BLOCK / 8 * frame.width;
+    std::memcpy(dst, packed, bytes);
+    dst += bytes;
+  }
+  pack_sequential(values + blocks * BLOCK, n - blocks * BLOCK, frame, dst);
+}
+
+void for_unpack(const char *data, size_t n, ForFrame frame, uint64_t *out) {
+  if (frame.width == 0) {
+    std::fill(out, out + n, frame.base);
+    return;
+  }
+  size_t blocks = frame.width <= 32 ? n / BLOCK : 0;
+  uint32_t packed[BLOCK];
+  for (size_t blk = 0; blk < blocks; ++blk) {
+    size_t bytes = BLOCK / 8 * frame.width;
+    std::memcpy(packed, data, bytes);
+    unpack_block(packed, frame.width, frame.base, out + blk * BLOCK);
+    data += bytes;
+  }
+  size_t rest = n - blocks * BLOCK;
+  unpack_sequential(data, sequential_size(rest, frame.width), rest, frame,
+                    out + blocks * BLOCK);
+}
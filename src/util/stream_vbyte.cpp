@@ -0,0 +1,157 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utils/StreamVByte.hpp>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LOGMD_STREAMVBYTE_X86 1
+#include <immintrin.h>
+#endif
+
+static inline uint32_t value_code(uint32_t v) {
+  return (v > 0xFF) + (v > 0xFFFF) + (v > 0xFFFFFF);
+}
+
+// 控制字节对应的 4 个值的数据长度，以及编码、解码时的字节重排表。
+// 重排表中的 0x80 使 pshufb 输出 0
+struct SvbTables {
+  uint8_t length[256];
+  uint8_t encode[256][16];
+  uint8_t decode[256][16];
+  uint8_t spread[16]; // 4 位掩码的第 i 位移到第 i * 2 位
+
+  SvbTables() {
+    for (uint32_t ctrl = 0; ctrl < 256; ++ctrl) {
+      std::memset(encode[ctrl], 0x80, 16);
+      std::memset(decode[ctrl], 0x80, 16);
+      uint8_t offset = 0;
+      for (uint8_t i = 0; i < 4; ++i) {
+        uint8_t len = ((ctrl >> (i * 2)) & 3) + 1;
+        for (uint8_t b = 0; b < len; ++b) {
+          encode[ctrl][offset + b] = i * 4 + b;
+          decode[ctrl][i * 4 + b] = offset + b;
+        }
+        offset += len;
+      }
+      length[ctrl] = offset;
+    }
+    for (uint32_t mask = 0; mask < 16; ++mask) {
+      spread[mask] = 0;
+      for (uint32_t i = 0; i < 4; ++i)
+        spread[mask] |= ((mask >> i) & 1) << (i * 2);
+    }
+  }
+};
+
+static const SvbTables tables;
+
+// ---------------------------------------------------------------------------
+// 逐值处理：不足 4 个值的尾部，以及不支持 SSSE3 的 CPU
+// ---------------------------------------------------------------------------
+
+static uint8_t *encode_scalar(const uint32_t *in, size_t n, uint8_t *ctrl,
+                              uint8_t *data) {
+  for (size_t i = 0; i < n; ++i) {
+    uint32_t v = in[i], code = value_code(v);
+    ctrl[i / 4] |= uint8_t(code << (i % 4 * 2));
+    for (uint32_t b = 0; b <= code; ++b)
+      *data++ = uint8_t(v >> (b * 8));
+  }
+  return data;
+}
+
+static const uint8_t *decode_scalar(const uint8_t *ctrl, size_t first,
+                                    size_t n, const uint8_t *data,
+                                    const uint8_t *end, uint32_t *out) {
+  for (size_t i = first; i < n; ++i) {
+    uint32_t len = ((ctrl[i / 4] >> (i % 4 * 2)) & 3) + 1;
+    if (size_t(end - data) < len)
+      return nullptr;
+    uint32_t v = 0;
+    for (uint32_t b = 0; b < len; ++b)
+      v |= uint32_t(data[b]) << (b * 8);
+    out[i] = v;
+    data += len;
+  }
+  return data;
+}
+
+#ifdef LOGMD_STREAMVBYTE_X86
+// pshufb 属于 SSSE3，只在运行时确认 CPU 支持后使用。
+// 每次写出 16 字节、前移实际长度，之后的写入会覆盖多写的部分；
+// 数据流总长不超过 4n，最后一组的多写也不会越过 svb_max_size
+__attribute__((target("ssse3"))) static uint8_t *
+encode_ssse3(const uint32_t *in, size_t groups, uint8_t *ctrl, uint8_t *data) {
+  // 无符号比较：两侧同时翻转符号位后做有符号比较
+  const __m128i sign = _mm_set1_epi32(int32_t(0x80000000)),
+                gt1 = _mm_set1_epi32(int32_t(0xFF ^ 0x80000000)),
+                gt2 = _mm_set1_epi32(int32_t(0xFFFF ^ 0x80000000)),
+                gt3 = _mm_set1_epi32(int32_t(0xFFFFFF ^ 0x80000000));
+  for (size_t g = 0; g < groups; ++g) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + g * 4));
+    __m128i x = _mm_xor_si128(v, sign);
+    int m1 = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(x, gt1))),
+        m2 = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(x, gt2))),
+        m3 = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(x, gt3)));
+    // 每个 2 位字段至多加到 3，不会进位
+    uint8_t c = tables.spread[m1] + tables.spread[m2] + tables.spread[m3];
+    ctrl[g] = c;
+    __m128i shuffle = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(tables.encode[c]));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(data),
+                     _mm_shuffle_epi8(v, shuffle));
+    data += tables.length[c];
+  }
+  return data;
+}
+
+// 只在剩余数据不少于 16 字节时整组解码，返回处理到的组
+__attribute__((target("ssse3"))) static size_t
+decode_ssse3(const uint8_t *ctrl, size_t groups, const uint8_t *&data,
+             const uint8_t *end, uint32_t *out) {
+  size_t g = 0;
+  for (; g < groups && end - data >= 16; ++g) {
+    uint8_t c = ctrl[g];
+    __m128i shuffle = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(tables.decode[c]));
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + g * 4),
+                     _mm_shuffle_epi8(v, shuffle));
+    data += tables.length[c];
+  }
+  return g;
+}
+
+static const bool has_ssse3 = [] {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("ssse3") != 0;
+}();
+#endif
+
+size_t svb_encode(const uint32_t *in, size_t n, uint8_t *out) {
+  size_t ctrl_size = (n + 3) / 4;
+  std::memset(out, 0, ctrl_size);
+  uint8_t *data = out + ctrl_size;
+  size_t done = 0;
+#ifdef LOGMD_STREAMVBYTE_X86
+  if (has_ssse3) {
+    data = encode_ssse3(in, n / 4, out, data);
+    done = n / 4 * 4;
+  }
+#endif
+  data = encode_scalar(in + done, n - done, out + done / 4, data);
+  return size_t(data - out);
+}
+
+bool svb_decode(const uint8_t *in, size_t size, size_t n, uint32_t *out) {
+  size_t ctrl_size = (n + 3) / 4;
+  if (size < ctrl_size)
+    return false;
+  const uint8_t *data = in + ctrl_size, *end = in + size;
+  size_t done = 0;
+#ifdef LOGMD_STREAMVBYTE_X86
+  if (has_ssse3)
+    done = decode_ssse3(in, n / 4, data, end, out) * 4;
+#endif
+  return decode_scalar(in, done, n, data, end, out) != nullptr;
+}
@@ -0,0 +1,32 @@
+#include "absl/container/flat_hash_map.h"
+#include <cstdint>
+#include <string>
+#include <utils/SubTokenSplitter.hpp>
+#include <utils/pcre2regex.hpp>
+
+// 非 ASCII 字符在日志中很少且种类有限，逐个码位交给 PCRE2 判定一次后缓存，
+// 保证与原先的 Unicode 属性判定完全一致
+bool is_unicode_alnum(uint32_t code_point) {
+  thread_local absl::flat_hash_map<uint32_t, bool> cache;
+  auto it = cache.find(code_point);
+  if (it != cache.end())
+    return it->second;
+
+  thread_local Pcre2Regex alnum_re(R"(^[\p{L}\p{N}]$)");
+  std::string utf8;
+  if (code_point < 0x800) {
+    utf8 += char(0xC0 | (code_point >> 6));
+  } else if (code_point < 0x10000) {
+    utf8 += char(0xE0 | (code_point >> 12));
+    utf8 += char(0x80 | ((code_point >> 6) & 0x3F));
+  } else {
+    utf8 += char(0xF0 | (code_point >> 18));
+    utf8 += char(0x80 | ((code_point >> 12) & 0x3F));
+    utf8 += char(0x80 | ((code_point >> 6) & 0x3F));
+  }
+  utf8 += char(0x80 | (code_point & 0x3F));
+
+  bool is_alnum = alnum_re.match(utf8);
+  cache.emplace(code_point, is_alnum);
+  return is_alnum;
+}
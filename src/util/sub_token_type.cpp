@@ -0,0 +1,91 @@
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utils/SubTokenType.hpp>
+
+void SubTokenTypeDetector::add(std::string_view run) {
+  min_len = run.size() < min_len ? run.size() : min_len;
+  max_len = run.size() > max_len ? run.size() : max_len;
+  if (run.empty() || (run.size() > 1 && run[0] == '0'))
+    decimal = false;
+  for (char c : run) {
+    if (c >= '0' && c <= '9')
+      continue;
+    decimal = false;
+    if (c >= 'a' && c <= 'f') {
+      has_lower = true;
+      upper = false;
+    } else if (c >= 'A' && c <= 'F') {
+      has_upper = true;
+      lower = false;
+    } else {
+      lower = upper = false;
+    }
+  }
+}
+
+SubTokenType SubTokenTypeDetector::type() const {
+  // 不超过 15 位的数字已由 TAGGED 按数值存放
+  if (decimal && max_len > 15 && max_len <= 19)
+    return SubTokenType::DECIMAL;
+  // 只含数字的定长列同样不改变原有的存放方式
+  if (min_len != max_len || max_len < 4 || max_len > 32)
+    return SubTokenType::TAGGED;
+  if (lower && has_lower)
+    return SubTokenType::HEX_LOWER;
+  if (upper && has_upper)
+    return SubTokenType::HEX_UPPER;
+  return SubTokenType::TAGGED;
+}
+
+static uint64_t parse_hex(std::string_view digits) {
+  uint64_t value = 0;
+  for (char c : digits) {
+    unsigned d = c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+    value = value << 4 | d;
+  }
+  return value;
+}
+
+void parse_sub_token(std::string_view run, SubTokenType type, uint64_t *out) {
+  if (type == SubTokenType::DECIMAL) {
+    uint64_t value = 0;
+    for (char c : run)
+      value = value * 10 + uint64_t(c - '0');
+    out[0] = value;
+    return;
+  }
+  if (run.size() > 16) {
+    out[0] = parse_hex(run.substr(0, run.size() - 16));
+    out[1] = parse_hex(run.substr(run.size() - 16));
+    return;
+  }
+  out[0] = parse_hex(run);
+}
+
+static void append_hex(std::string &out, uint64_t value, size_t width,
+                       const char *digits) {
+  char buf[16];
+  for (size_t i = width; i-- > 0;) {
+    buf[i] = digits[value & 0xF];
+    value >>= 4;
+  }
+  out.append(buf, width);
+}
+
+void append_sub_token(std::string &out, SubTokenType type, size_t width,
+                      const uint64_t *values) {
+  if (type == SubTokenType::DECIMAL) {
+    out += std::to_string(values[0]);
+    return;
+  }
+  const char *digits = type == SubTokenType::HEX_UPPER ? "0123456789ABCDEF"
+                                                       : "0123456789abcdef";
+  if (width > 16) {
+    append_hex(out, values[0], width - 16, digits);
+    append_hex(out, values[1], 16, digits);
+    return;
+  }
+  append_hex(out, values[0], width, digits);
+}
@@ -0,0 +1,268 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utils/Timestamp.hpp>
+
+// 字段字母：YYYY 四位年，yy 两位年（20yy），MM 月，bbb 英文月份缩写，
+// DD 日，ee 以空格补齐的日，hh 时，mm 分，ss 秒，每个 f 为一位小数；
+// 其余字符按原文匹配
+static constexpr const char *FORMATS[] = {
+    "YYYY-MM-DD hh:mm:ss,fff", // log4j、Python logging
+    "YYYY-MM-DD hh:mm:ss.fff",
+    "YYYY-MM-DD hh:mm:ss.ffffff",
+    "YYYY-MM-DD hh:mm:ss",
+    "YYYY-MM-DDThh:mm:ss.fff", // ISO 8601
+    "YYYY-MM-DDThh:mm:ss.ffffff",
+    "YYYY-MM-DDThh:mm:ss",
+    "YYYY/MM/DD hh:mm:ss",
+    "YYYY-MM-DD-hh.mm.ss.ffffff", // BGL
+    "YYYYMMDD-hh:mm:ss:fff",      // HealthApp
+    "yyMMDD hhmmss",              // HDFS
+    "yy/MM/DD hh:mm:ss",          // Spark
+    "MM-DD hh:mm:ss.fff",         // Android
+    "bbb ee hh:mm:ss",            // syslog
+};
+static constexpr size_t FORMAT_COUNT = sizeof(FORMATS) / sizeof(FORMATS[0]);
+
+static constexpr char MONTH_NAMES[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+size_t timestamp_format_count() { return FORMAT_COUNT; }
+
+static bool is_field(char c) {
+  return c == 'Y' || c == 'y' || c == 'M' || c == 'b' || c == 'D' ||
+         c == 'e' || c == 'h' || c == 'm' || c == 's' || c == 'f';
+}
+
+static size_t fraction_digits(const char *spec) {
+  size_t digits = 0;
+  for (; *spec; ++spec)
+    digits += *spec == 'f';
+  return digits;
+}
+
+static int64_t power_of_ten(size_t n) {
+  int64_t p = 1;
+  while (n--)
+    p *= 10;
+  return p;
+}
+
+static bool is_leap(int64_t y) {
+  return y % 4 == 0 && (y % 100 != 0 || y % 400 == 0);
+}
+
+static int days_in_month(int64_t y, int m) {
+  static constexpr int DAYS[] = {31, 28, 31, 30, 31, 30,
+                                 31, 31, 30, 31, 30, 31};
+  return m == 2 && is_leap(y) ? 29 : DAYS[m - 1];
+}
+
+// 公历日期与 1970-01-01 起的天数互转（Howard Hinnant 的算法）
+static int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+  y -= m <= 2;
+  int64_t era = (y >= 0 ? y : y - 399) / 400;
+  unsigned yoe = unsigned(y - era * 400);
+  unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + int64_t(doe) - 719468;
+}
+
+static void civil_from_days(int64_t z, int64_t &y, unsigned &m, unsigned &d) {
+  z += 719468;
+  int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+  unsigned doe = unsigned(z - era * 146097);
+  unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  unsigned mp = (5 * doy + 2) / 153;
+  d = doy - (153 * mp + 2) / 5 + 1;
+  m = mp < 10 ? mp + 3 : mp - 9;
+  y = int64_t(yoe) + era * 400 + (m <= 2);
+}
+
+// 按 spec 匹配 line 的开头。各字段定宽且取值合法，
+// 因此 append_timestamp 能逐字节还原
+static bool parse_timestamp(const char *spec, std::string_view line,
+                            size_t &length, int64_t &value) {
+  int64_t year = 2000, frac = 0;
+  int month = 1, day = 1, hour = 0, minute = 0, second = 0;
+  size_t pos = 0;
+  for (const char *p = spec; *p;) {
+    char c = *p;
+    if (!is_field(c)) {
+      if (pos >= line.size() || line[pos] != c)
+        return false;
+      ++pos;
+      ++p;
+      continue;
+    }
+    size_t width = 1;
+    while (p[width] == c)
+      ++width;
+    p += width;
+    if (line.size() - pos < width)
+      return false;
+    const char *text = line.data() + pos;
+    pos += width;
+
+    if (c == 'b') {
+      month = 0;
+      for (int i = 0; i < 12 && month == 0; ++i) {
+        if (memcmp(MONTH_NAMES + i * 3, text, 3) == 0)
+          month = i + 1;
+      }
+      if (month == 0)
+        return false;
+      continue;
+    }
+    int64_t n = 0;
+    for (size_t i = 0; i < width; ++i) {
+      if (c == 'e' && i == 0 && text[i] == ' ')
+        continue;
+      if (text[i] < '0' || text[i] > '9')
+        return false;
+      n = n * 10 + (text[i] - '0');
+    }
+    switch (c) {
+    case 'Y':
+      year = n;
+      break;
+    case 'y':
+      year = 2000 + n;
+      break;
+    case 'M':
+      month = int(n);
+      break;
+    case 'e':
+      // 一位数的日必须以空格补齐，两位数的日不能以 0 开头
+      if ((text[0] == ' ') != (n < 10))
+        return false;
+      day = int(n);
+      break;
+    case 'D':
+      day = int(n);
+      break;
+    case 'h':
+      hour = int(n);
+      break;
+    case 'm':
+      minute = int(n);
+      break;
+    case 's':
+      second = int(n);
+      break;
+    default: // 'f'
+      frac = n;
+      break;
+    }
+  }
+  // 其后仍是数字时不是完整的时间戳
+  if (pos < line.size() && line[pos] >= '0' && line[pos] <= '9')
+    return false;
+  // 闰秒（:60）折算后无法还原，同样不识别
+  if (month < 1 || month > 12 || day < 1 ||
+      day > days_in_month(year, month) || hour > 23 || minute > 59 ||
+      second > 59)
+    return false;
+
+  int64_t seconds = days_from_civil(year, unsigned(month), unsigned(day)) *
+                        86400 +
+                    hour * 3600 + minute * 60 + second;
+  value = seconds * power_of_ten(fraction_digits(spec)) + frac;
+  length = pos;
+  return true;
+}
+
+int match_timestamp(std::string_view line, size_t hint, size_t &length,
+                    int64_t &value) {
+  if (line.empty())
+    return -1;
+  // 所有格式都以数字或月份缩写开头
+  char first = line[0];
+  if (!(first >= '0' && first <= '9') && !(first >= 'A' && first <= 'Z'))
+    return -1;
+  if (hint < FORMAT_COUNT &&
+      parse_timestamp(FORMATS[hint], line, length, value))
+    return int(hint);
+  for (size_t i = 0; i < FORMAT_COUNT; ++i) {
+    if (i != hint && parse_timestamp(FORMATS[i], line, length, value))
+      return int(i);
+  }
+  return -1;
+}
+
+// 写出 n 的低 width 位十进制数，不足时以 pad 补齐
+static void append_field(std::string &out, int64_t n, size_t width, char pad) {
+  int64_t p = power_of_ten(width);
+  n = (n % p + p) % p;
+  char buf[20];
+  for (size_t i = width; i-- > 0;) {
+    buf[i] = char('0' + n % 10);
+    n /= 10;
+  }
+  for (size_t i = 0; i + 1 < width && buf[i] == '0'; ++i)
+    buf[i] = pad;
+  out.append(buf, width);
+}
+
+void append_timestamp(std::string &out, size_t format, int64_t value) {
+  const char *spec = FORMATS[format];
+  int64_t scale = power_of_ten(fraction_digits(spec));
+  int64_t frac = value % scale, seconds = value / scale;
+  if (frac < 0) {
+    frac += scale;
+    --seconds;
+  }
+  int64_t days = seconds / 86400, rest = seconds % 86400;
+  if (rest < 0) {
+    rest += 86400;
+    --days;
+  }
+  int64_t year;
+  unsigned month, day;
+  civil_from_days(days, year, month, day);
+
+  for (const char *p = spec; *p;) {
+    char c = *p;
+    if (!is_field(c)) {
+      out += c;
+      ++p;
+      continue;
+    }
+    size_t width = 1;
+    while (p[width] == c)
+      ++width;
+    p += width;
+    switch (c) {
+    case 'Y':
+    case 'y':
+      append_field(out, year, width, '0');
+      break;
+    case 'M':
+      append_field(out, month, width, '0');
+      break;
+    case 'b':
+      out.append(MONTH_NAMES + (month - 1) * 3, 3);
+      break;
+    case 'D':
+      append_field(out, day, width, '0');
+      break;
+    case 'e':
+      append_field(out, day, width, ' ');
+      break;
+    case 'h':
+      append_field(out, rest / 3600, width, '0');
+      break;
+    case 'm':
+      append_field(out, rest / 60 % 60, width, '0');
+      break;
+    case 's':
+      append_field(out, rest % 60, width, '0');
+      break;
+    default: // 'f'
+      append_field(out, frac, width, '0');
+      break;
+    }
+  }
+}
@@ -0,0 +1,100 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utils/TokenClassifier.hpp>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+// 每 16 字节得到数字、字母、/、非 ASCII 四个位掩码，valid 为有效字节的位
+static inline void classify_block(const char *data, uint32_t valid,
+                                  uint32_t &digit, uint32_t &alpha,
+                                  uint32_t &slash, uint32_t &high) {
+  const __m128i zero = _mm_set1_epi8('0'), nine_span = _mm_set1_epi8(9),
+                lower_a = _mm_set1_epi8('a'), alpha_span = _mm_set1_epi8(25),
+                case_bit = _mm_set1_epi8(0x20), slash_c = _mm_set1_epi8('/');
+  __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+  // 无符号比较 lo <= x <= lo + span：x - lo 饱和到 span 后不变
+  __m128i d = _mm_sub_epi8(x, zero);
+  __m128i a = _mm_sub_epi8(_mm_or_si128(x, case_bit), lower_a);
+  digit = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(d, nine_span), d)) &
+          valid;
+  alpha = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(a, alpha_span), a)) &
+          valid;
+  slash = _mm_movemask_epi8(_mm_cmpeq_epi8(x, slash_c)) & valid;
+  high = _mm_movemask_epi8(x) & valid;
+}
+
+TokenCharFlags classify_token_chars(std::string_view token) {
+  uint32_t digit = 0, alpha = 0, slash = 0, high = 0, other = 0;
+  const char *cur = token.data(), *end = cur + token.size();
+  // 不足 16 字节的尾部复制到缓冲区，避免越界读取
+  while (cur < end) {
+    char buf[16];
+    const char *block = cur;
+    uint32_t valid = 0xFFFF;
+    if (end - cur < 16) {
+      std::memset(buf, 0, sizeof(buf));
+      std::memcpy(buf, cur, end - cur);
+      block = buf;
+      valid = (1u << (end - cur)) - 1;
+    }
+    uint32_t d, a, s, h;
+    classify_block(block, valid, d, a, s, h);
+    digit |= d;
+    alpha |= a;
+    slash |= s;
+    high |= h;
+    other |= valid & ~(d | a);
+    cur += 16;
+  }
+
+  TokenCharFlags flags;
+  flags.has_digit = digit != 0;
+  flags.has_alpha = alpha != 0;
+  flags.has_punct = other != 0;
+  flags.all_digit = !token.empty() && !flags.has_alpha && !flags.has_punct;
+  flags.has_slash = slash != 0;
+  flags.non_ascii = high != 0;
+  return flags;
+}
+#else
+namespace {
+enum : uint8_t { DIGIT = 1, ALPHA = 2, SLASH = 4, HIGH = 8 };
+
+struct CharFlagTable {
+  uint8_t flags[256];
+  constexpr CharFlagTable() : flags() {
+    for (int c = 0; c < 256; ++c) {
+      if (c >= '0' && c <= '9')
+        flags[c] = DIGIT;
+      else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+        flags[c] = ALPHA;
+      else if (c == '/')
+        flags[c] = SLASH;
+      else if (c >= 0x80)
+        flags[c] = HIGH;
+    }
+  }
+};
+constexpr CharFlagTable CHAR_FLAGS{};
+} // namespace
+
+TokenCharFlags classify_token_chars(std::string_view token) {
+  uint8_t seen = 0;
+  bool has_punct = false;
+  for (unsigned char c : token) {
+    uint8_t f = CHAR_FLAGS.flags[c];
+    seen |= f;
+    has_punct |= !(f & (DIGIT | ALPHA));
+  }
+  TokenCharFlags flags;
+  flags.has_digit = seen & DIGIT;
+  flags.has_alpha = seen & ALPHA;
+  flags.has_punct = has_punct;
+  flags.all_digit = !token.empty() && !flags.has_alpha && !has_punct;
+  flags.has_slash = seen & SLASH;
+  flags.non_ascii = seen & HIGH;
+  return flags;
+}
+#endif
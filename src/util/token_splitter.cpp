@@ -0,0 +1,99 @@
+#include <cstddef>
+#include <cstdint>
+#include <utils/TokenSplitter.hpp>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LOGMD_TOKENSPLITTER_X86 1
+#include <immintrin.h>
+#endif
+
+static inline bool is_delim_candidate(unsigned char c) {
+  return c == ' ' || c == '|' || (c >= '\t' && c <= '\r') || c == 0xC2 ||
+         (c >= 0xE1 && c <= 0xE3);
+}
+
+static const char *find_token_delim_scalar(const char *cur, const char *end) {
+  while (cur < end && !is_delim_candidate(static_cast<unsigned char>(*cur)))
+    ++cur;
+  return cur;
+}
+
+#ifdef LOGMD_TOKENSPLITTER_X86
+// 无符号比较 lo <= x <= lo + span：x - lo 饱和到 span 后不变
+#define LOGMD_IN_RANGE(bits, x, lo, span)                                      \
+  _mm##bits##_cmpeq_epi8(                                                      \
+      _mm##bits##_min_epu8(_mm##bits##_sub_epi8(x, lo), span),                \
+      _mm##bits##_sub_epi8(x, lo))
+
+// 16 字节中候选字节的位掩码
+static inline int delim_mask_sse2(const char *cur) {
+  const __m128i space = _mm_set1_epi8(' '), pipe = _mm_set1_epi8('|'),
+                c2 = _mm_set1_epi8(char(0xC2)), tab = _mm_set1_epi8('\t'),
+                e1 = _mm_set1_epi8(char(0xE1)), four = _mm_set1_epi8(4),
+                two = _mm_set1_epi8(2);
+  __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(cur));
+  __m128i m = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(x, space), _mm_cmpeq_epi8(x, pipe)),
+      _mm_or_si128(_mm_cmpeq_epi8(x, c2),
+                   _mm_or_si128(LOGMD_IN_RANGE(, x, tab, four),
+                                LOGMD_IN_RANGE(, x, e1, two))));
+  return _mm_movemask_epi8(m);
+}
+
+// SSE2 是 x86-64 的基线指令集，每次检查 16 字节
+static const char *find_token_delim_sse2(const char *cur, const char *end) {
+  for (; end - cur >= 16; cur += 16) {
+    if (int mask = delim_mask_sse2(cur))
+      return cur + __builtin_ctz(mask);
+  }
+  return find_token_delim_scalar(cur, end);
+}
+
+// AVX2 每次检查 32 字节，只在运行时确认 CPU 支持后使用
+__attribute__((target("avx2"))) static const char *
+find_token_delim_avx2(const char *cur, const char *end) {
+  const __m256i space = _mm256_set1_epi8(' '), pipe = _mm256_set1_epi8('|'),
+                c2 = _mm256_set1_epi8(char(0xC2)),
+                tab = _mm256_set1_epi8('\t'),
+                e1 = _mm256_set1_epi8(char(0xE1)),
+                four = _mm256_set1_epi8(4), two = _mm256_set1_epi8(2);
+  for (; end - cur >= 32; cur += 32) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cur));
+    __m256i m = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(x, space),
+                        _mm256_cmpeq_epi8(x, pipe)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(x, c2),
+                        _mm256_or_si256(LOGMD_IN_RANGE(256, x, tab, four),
+                                        LOGMD_IN_RANGE(256, x, e1, two))));
+    uint32_t mask = uint32_t(_mm256_movemask_epi8(m));
+    if (mask)
+      return cur + __builtin_ctz(mask);
+  }
+  // 编译器在尾调用前不会插入 vzeroupper，之后的 SSE 指令会因
+  // YMM 高位未清零而明显变慢，这里显式清零
+  _mm256_zeroupper();
+  return find_token_delim_sse2(cur, end);
+}
+#undef LOGMD_IN_RANGE
+
+static const bool has_avx2 = [] {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") != 0;
+}();
+
+const char *find_token_delim(const char *cur, const char *end) {
+  // 日志 token 大多很短，分隔符通常落在前 16 字节内。
+  // 进出 AVX2 代码有固定开销，只有长 token 才交给 AVX2 循环
+  if (end - cur < 16)
+    return find_token_delim_scalar(cur, end);
+  if (int mask = delim_mask_sse2(cur))
+    return cur + __builtin_ctz(mask);
+  cur += 16;
+  return has_avx2 ? find_token_delim_avx2(cur, end)
+                  : find_token_delim_sse2(cur, end);
+}
+#else
+const char *find_token_delim(const char *cur, const char *end) {
+  return find_token_delim_scalar(cur, end);
+}
+#endif
@@ -5,9 +5,10 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <utils/util.hpp>
 
-bool is_numeric(const std::string &str) {
+bool is_numeric(std::string_view str) {
   return !str.empty() && std::all_of(str.begin(), str.end(), ::isdigit);
 }
 